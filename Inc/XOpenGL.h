@@ -98,8 +98,22 @@
 #define DRAWTILE_SIZE 1024
 #define DRAWCOMPLEX_SIZE 1024
 #define DRAWGOURAUDPOLY_SIZE 1024
+#define DRAWCOMPLEX_STATIC_SIZE (1024 * 1024)
+#define DRAWGOURAUD_STATIC_SIZE (256 * 1024)
+#define MAX_CLIP_PLANES 128 // Size of the per-frame clip plane table
+#define MAX_DISTANCE_FOGS 64 // Size of the per-frame distance fog table
 #define NUMBUFFERS 8
 
+// Tile atlas (UseTileAtlas)
+#define TILE_ATLAS_PAGE_SIZE 1024
+#define TILE_ATLAS_MAX_PAGES 4
+#define TILE_ATLAS_MAX_TEXTURE_SIZE 256
+
+// Texture array pools (UseTextureArrays)
+#define TEXTURE_POOL_BYTES (16 * 1024 * 1024)
+#define TEXTURE_POOL_MAX_LAYERS 64
+#define TEXTURE_POOL_MAX_TEXTURE_SIZE 512
+
 #if ENGINE_VERSION>=430 && ENGINE_VERSION<1100
 # define MAX_LIGHTS 256
 #else
@@ -334,6 +348,12 @@ inline glm::vec4 FPlaneToVec4(FPlane Plane)
 	return glm::vec4(Plane.X, Plane.Y, Plane.Z, Plane.W);
 }
 
+// Packs a color into an RGBA8 vertex attribute
+inline glm::uint PackColor(const FPlane& C)
+{
+	return glm::packUnorm4x8(glm::vec4(C.X, C.Y, C.Z, C.W));
+}
+
 #ifndef END_LINE
 #define END_LINE "\n"
 #endif
@@ -478,9 +498,15 @@ class UXOpenGLRenderDevice : public URenderDevice
 	BITFIELD UsePersistentBuffers;
 	BITFIELD UseBufferInvalidation;
 	BITFIELD UseShaderDrawParameters;
+	BITFIELD UseStaticBSPCache;
+	BITFIELD UseMeshBuffering; //Buffer (Static)Meshes for drawing.
+	BITFIELD UseDeferredOpaqueDraws;
+	BITFIELD UseWorkerThreads;
+	BITFIELD UseTileAtlas;
+	BITFIELD UseTextureArrays;
+	BITFIELD UseGPUTriangleRejection;
 
 	// Not really in use...(yet)
-	BITFIELD UseMeshBuffering; //Buffer (Static)Meshes for drawing.
 	BITFIELD UseSRGBTextures;
 	BITFIELD EnvironmentMaps;
 
@@ -503,6 +529,15 @@ class UXOpenGLRenderDevice : public URenderDevice
 	bool	UsingPersistentBuffers;
 	bool	UsingShaderDrawParameters;
 	bool    UsingGeometryShaders;
+	bool	UsingStaticBSPCache;
+	bool	UsingMeshBuffering;
+	bool	UsingDeferredOpaqueDraws;
+	bool	UsingWorkerThreads;
+	bool	UsingTileAtlas;
+	bool	UsingTextureArrays;
+	bool	UsingGPUTriangleRejection;
+	bool	UsingIndexedFans;
+	bool	UsingIndirectDraws;
 	static INT LogLevel; // Verbosity level of the GL debug logging
 
 	//
@@ -540,6 +575,10 @@ class UXOpenGLRenderDevice : public URenderDevice
 	INT    RenderFBOHeight;
 	UBOOL  RenderFBOBound;
 
+	// Splits up big vertex conversion jobs across all cores (UseWorkerThreads)
+	typedef void (*FGLJobFunc)(void* Context, INT Begin, INT End);
+	class FGLWorkerPool* WorkerPool;
+
 	// Context specifics.
 	INT DesiredColorBits;
 	INT DesiredStencilBits;
@@ -601,6 +640,9 @@ class UXOpenGLRenderDevice : public URenderDevice
 	//
 	GLuint NumClipPlanes;
 	BYTE LastZMode;
+	bool GouraudEnvironmentUVs{}; // DrawGouraudTriangles leaves environment mapping to the vertex shader
+	GLenum GouraudCullFace{GL_NONE}; // DrawGouraudTriangles leaves face culling to the GPU. GL_NONE culls nothing
+	GLenum BatchCullFace{GL_NONE}; // Face culling the pending Gouraud draws were buffered with
 	DWORD CachedPolyFlags; // The last set of polyflags we derived drawflags for
 	DWORD CachedDrawFlags; // And the corresponding drawflags
 
@@ -618,7 +660,6 @@ class UXOpenGLRenderDevice : public URenderDevice
 	FLOAT StoredOrthoFovAngle;
 	FLOAT StoredOrthoFX;
 	FLOAT StoredOrthoFY;
-	UBOOL StoredbNearZ;
 	FLOAT StoredGamma;
 	UBOOL StoredOneXBlending;
 	UBOOL StoredActorXBlending;
@@ -627,6 +668,27 @@ class UXOpenGLRenderDevice : public URenderDevice
 	//
 	// Performance Statistics
 	//
+
+	// Why we dispatched a batch of draw calls
+	enum FlushReason
+	{
+		Flush_None,
+		Flush_BufferFull,		// No room left in the vertex, parameters, material or multi-draw buffers
+		Flush_Texture,			// Texture bind, eviction or (re)upload
+		Flush_Blend,			// Blending mode or line flags change
+		Flush_Program,			// Switch to a different shader program
+		Flush_EndOfScene,		// SetSceneNode, Unlock, Flush, ...
+		Flush_ClipPlane,		// PushClipPlane/PopClipPlane
+		Flush_ZTest,			// SetZTestMode
+		Flush_DepthTest,		// Depth testing toggled for the HUD
+		Flush_DistanceFog,		// SetDistanceFog/ResetDistanceFog
+		Flush_NearZ,			// Projection change for NearZ meshes
+		Flush_PopHit,			// Hit testing in the editor
+		Flush_ClearZ,
+		Flush_Culling,			// Face culling change for Gouraud triangle lists
+		Flush_Max
+	};
+
 	struct FGLStats
 	{
 		DWORD BindCycles;
@@ -642,7 +704,210 @@ class UXOpenGLRenderDevice : public URenderDevice
 		DWORD TriangleCycles;
 		DWORD Resample7777Cycles;
 		INT StallCount;
+
+		// Dispatched batches and their contents, per FlushReason
+		DWORD Flushes[Flush_Max];
+		DWORD FlushedDrawCalls[Flush_Max];
+		DWORD FlushedVertices[Flush_Max];
+		DWORD MaxBatchDrawCalls;
+
+		void RecordFlush(INT Reason, INT DrawCalls, INT Vertices)
+		{
+			Flushes[Reason]++;
+			FlushedDrawCalls[Reason] += DrawCalls;
+			FlushedVertices[Reason] += Vertices;
+			MaxBatchDrawCalls = Max<DWORD>(MaxBatchDrawCalls, DrawCalls);
+		}
 	} Stats;
+	static const TCHAR* FlushReasonNames[Flush_Max];
+
+	//
+	// GL State Cache
+	//
+	// Shadows the global GL state we change while rendering, so we can filter out redundant state changes.
+	// State we have not set ourselves yet, or that may have been changed behind our back (e.g., because
+	// we switched contexts or deleted a bound object) is unknown and always gets applied.
+	//
+	struct FGLStateCache
+	{
+		enum
+		{
+			MaxTextureUnits	= 16,
+			UnknownState	= 0xFFFFFFFF
+		};
+
+		DWORD EnabledCaps;						// Bitmask of tracked capabilities that are enabled
+		DWORD KnownCaps;						// Bitmask of tracked capabilities whose state we know
+		DWORD BlendFunc;						// (SrcFactor << 16) | DstFactor
+		DWORD DepthFunc;
+		DWORD CullFace;
+		BYTE  DepthMask;						// GL_TRUE, GL_FALSE or 0xFF if unknown
+		BYTE  ColorMask;						// GL_TRUE, GL_FALSE or 0xFF if unknown
+		glm::vec4 BlendColor;					// NaN if unknown
+		DWORD Program;
+		DWORD ActiveTextureUnit;
+		DWORD Textures[MaxTextureUnits];
+		DWORD Samplers[MaxTextureUnits];
+
+		// Number of state changes we passed on to GL and filtered out this frame
+		DWORD Issued;
+		DWORD Filtered;
+
+		void Invalidate()
+		{
+			EnabledCaps = KnownCaps = 0;
+			BlendFunc = DepthFunc = CullFace = UnknownState;
+			DepthMask = ColorMask = 0xFF;
+			BlendColor = glm::vec4(NAN);
+			InvalidateProgram();
+			InvalidateTextures();
+		}
+
+		void InvalidateProgram()
+		{
+			Program = UnknownState;
+		}
+
+		// Deleting a texture or sampler silently unbinds it from every TMU
+		void InvalidateTextures()
+		{
+			ActiveTextureUnit = UnknownState;
+			for (INT i = 0; i < MaxTextureUnits; ++i)
+				Textures[i] = Samplers[i] = UnknownState;
+		}
+
+		// Returns true if the caller should apply the state change
+		bool Update(DWORD& Shadow, DWORD Value)
+		{
+			if (Shadow == Value)
+			{
+				Filtered++;
+				return false;
+			}
+			Shadow = Value;
+			Issued++;
+			return true;
+		}
+
+		static DWORD GetCapabilityBit(GLenum Cap)
+		{
+			switch (Cap)
+			{
+			case GL_BLEND:			return 1 << 0;
+			case GL_DEPTH_TEST:		return 1 << 1;
+			case GL_CULL_FACE:		return 1 << 2;
+			case GL_MULTISAMPLE:	return 1 << 3;
+			default:
+				// One bit per clip distance we use
+				if (Cap >= GL_CLIP_DISTANCE0 && Cap < GL_CLIP_DISTANCE0 + 8)
+					return 1 << (4 + Cap - GL_CLIP_DISTANCE0);
+				return 0;
+			}
+		}
+
+		void SetEnabled(GLenum Cap, bool Enable)
+		{
+			const DWORD Bit = GetCapabilityBit(Cap);
+			if ((KnownCaps & Bit) && ((EnabledCaps & Bit) != 0) == Enable)
+			{
+				Filtered++;
+				return;
+			}
+
+			KnownCaps |= Bit;
+			if (Enable)
+				EnabledCaps |= Bit;
+			else
+				EnabledCaps &= ~Bit;
+
+			Issued++;
+			if (Enable)
+				glEnable(Cap);
+			else
+				glDisable(Cap);
+		}
+
+		void SetBlendFunc(GLenum SrcFactor, GLenum DstFactor)
+		{
+			if (Update(BlendFunc, (SrcFactor << 16) | DstFactor))
+				glBlendFunc(SrcFactor, DstFactor);
+		}
+
+		void SetBlendColor(FLOAT R, FLOAT G, FLOAT B, FLOAT A)
+		{
+			const glm::vec4 Color(R, G, B, A);
+			if (BlendColor == Color)
+			{
+				Filtered++;
+				return;
+			}
+			BlendColor = Color;
+			Issued++;
+			glBlendColor(R, G, B, A);
+		}
+
+		void SetDepthFunc(GLenum Func)
+		{
+			if (Update(DepthFunc, Func))
+				glDepthFunc(Func);
+		}
+
+		void SetCullFace(GLenum Face)
+		{
+			if (Update(CullFace, Face))
+				glCullFace(Face);
+		}
+
+		void SetDepthMask(bool Write)
+		{
+			DWORD Shadow = DepthMask == 0xFF ? UnknownState : DepthMask;
+			if (Update(Shadow, Write ? GL_TRUE : GL_FALSE))
+			{
+				DepthMask = static_cast<BYTE>(Shadow);
+				glDepthMask(Write ? GL_TRUE : GL_FALSE);
+			}
+		}
+
+		void SetColorMask(bool Write)
+		{
+			DWORD Shadow = ColorMask == 0xFF ? UnknownState : ColorMask;
+			if (Update(Shadow, Write ? GL_TRUE : GL_FALSE))
+			{
+				ColorMask = static_cast<BYTE>(Shadow);
+				const GLboolean Mask = Write ? GL_TRUE : GL_FALSE;
+				glColorMask(Mask, Mask, Mask, Mask);
+			}
+		}
+
+		void UseProgram(GLuint ProgramObject)
+		{
+			if (Update(Program, ProgramObject))
+				glUseProgram(ProgramObject);
+		}
+
+		void SetActiveTexture(INT Unit)
+		{
+			if (Update(ActiveTextureUnit, Unit))
+				glActiveTexture(GL_TEXTURE0 + Unit);
+		}
+
+		// Binds @Texture to @Unit. Leaves @Unit active so the caller can upload texture data.
+		// Every unit only ever holds textures of one @Target
+		void BindTexture(INT Unit, GLuint Texture, GLenum Target=GL_TEXTURE_2D)
+		{
+			check(Unit < MaxTextureUnits);
+			SetActiveTexture(Unit);
+			if (Update(Textures[Unit], Texture))
+				glBindTexture(Target, Texture);
+		}
+
+		void BindSampler(INT Unit, GLuint Sampler)
+		{
+			check(Unit < MaxTextureUnits);
+			if (Update(Samplers[Unit], Sampler))
+				glBindSampler(Unit, Sampler);
+		}
+	} GLState;
 
 	//
 	// Texture State
@@ -657,12 +922,42 @@ class UXOpenGLRenderDevice : public URenderDevice
 		GLuint Sampler;				// Sampler object
 		GLuint64 BindlessTexHandle;	// Bindless handle
 		INT RealtimeChangeCount{};
+		INT ArrayPool;				// 1-based index into TexturePools if the texture is a layer of a texture array. 0 otherwise
+		INT ArrayLayer;
 	};
 
 	// All currently cached textures.
 	TOpenGLMap<QWORD,FCachedTexture> LocalBindMap, *BindMap;
 	static TOpenGLMap<QWORD, FCachedTexture>* SharedBindMap; // Shared between GL contexts (e.g., in UED)	
 
+	//
+	// Direct-mapped lookaside in front of the BindMap. Most draws use the textures of
+	// the previous draw, so this saves us most of the hash lookups. BindMap entries move
+	// when the map grows, so adding or removing any entry invalidates the lookaside
+	//
+	struct FBindLookaside
+	{
+		QWORD CacheID;
+		FCachedTexture* Bind;
+	};
+	enum { BIND_LOOKASIDE_SIZE = 256 };
+	FBindLookaside BindLookaside[BIND_LOOKASIDE_SIZE];
+	DWORD BindLookasideSerial;
+
+	// BENCHTEXTURELOOKUPS records the CacheIDs FindCachedTexture looks up in one frame and replays them
+	TArray<QWORD> RecordedCacheIDs;
+	bool RecordNextFrameCacheIDs{};
+	bool RecordingCacheIDs{};
+	static DWORD BindMapSerial;		// Bumped whenever any BindMap changes
+
+	// A texture CheckTexture already looked up, so SetTexture can skip the lookup
+	struct FResolvedTexture
+	{
+		QWORD CacheID;
+		FCachedTexture* Bind;
+		DWORD BindMapSerial;
+	};
+
 	// Describes a currently active (and potentially bound to a TMU) texture
 	struct FTexInfo
 	{
@@ -677,6 +972,64 @@ class UXOpenGLRenderDevice : public URenderDevice
 	
 	bool UsingBindlessTextures;		// Are we currently using bindless textures?
 
+	//
+	// Per-frame memo of resolved detail, macro and bump textures. Render hands us the same few
+	// of these for every poly of a mesh or surface, and each one used to cost a texture lock and a
+	// BindMap lookup. Entries are only valid during the frame in which they were created
+	//
+	struct FTextureLookup
+	{
+		UTexture* Texture;
+		DWORD Frame;
+		INT RealtimeChangeCount;
+		QWORD CacheID;				// Tagged CacheID of the bound texture. BindMap entries can move, so we don't keep a pointer
+		GLuint64 BindlessTexHandle;
+		FLOAT UMult, VMult, UPan, VPan;
+	};
+	enum { TEXTURE_LOOKUP_SIZE = 64 };
+	FTextureLookup TextureLookups[TEXTURE_LOOKUP_SIZE];
+	DWORD TextureLookupFrame;
+
+	DWORD FrameCount;				// Incremented in every Lock
+
+	//
+	// Tile atlas. Small static tile textures such as font pages and HUD icons share a
+	// handful of big pages so DrawTile can switch between them without flushing
+	//
+	struct FTileAtlasEntry
+	{
+		INT Page;
+		INT X, Y;			// Top left texel of the texture, inside its 1 texel gutter
+		INT USize, VSize;
+	};
+
+	struct FTileAtlasPage
+	{
+		GLuint Id;
+		INT ShelfX, ShelfY, ShelfHeight;
+	};
+
+	TOpenGLMap<QWORD, FTileAtlasEntry> TileAtlasMap;
+	TArray<FTileAtlasPage> TileAtlasPages;
+	GLuint TileAtlasSamplers[2]{};	// Smooth and PF_NoSmooth
+
+	//
+	// Texture array pools. Without bindless textures, diffuse textures of the same format,
+	// size, and sampler state can live in the layers of a shared GL_TEXTURE_2D_ARRAY. The
+	// draw parameters then select the layer, so switching between them does not break the batch
+	//
+	struct FTexturePool
+	{
+		GLuint Id;
+		GLuint Sampler;
+		INT USize, VSize, NumLevels;
+		DWORD SamplerFlags;
+		INT NumLayers, MaxLayers;
+	};
+
+	TArray<FTexturePool> TexturePools;
+	INT BoundTexturePool{};		// 1-based index of the pool bound to TextureArrayIndex
+
 	//
 	// Hit Testing State
 	//
@@ -888,6 +1241,11 @@ class UXOpenGLRenderDevice : public URenderDevice
 			return bBound;
 		}
 
+		bool IsPersistent() const
+		{
+			return bPersistentBuffer;
+		}
+
 		bool IsInputLayoutCreated() const
 		{
 			return bInputLayoutCreated;
@@ -1061,73 +1419,565 @@ class UXOpenGLRenderDevice : public URenderDevice
 	};
     
 	//
-	// Helper class for glMultiDrawArrays batching
+	// Helper class for multi-draw batching. Every draw call we queue becomes an indirect draw
+	// command that draws a single instance (or a run of instances, see AddInstance). The
+	// baseInstance of the command is the DrawID of the call, which the shaders fetch through an instanced vertex attribute (see
+	// ShaderProgram::CreateDrawIDInputLayout).
+	//
+	// Devices without indirect draws can't select the DrawID through the baseInstance. There, we
+	// write the DrawID of every vertex into a separate stream and turn the commands back into
+	// glMultiDrawArrays and glMultiDrawElementsBaseVertex calls (see PerVertexDrawIDs)
 	//
 	class MultiDrawBuffer
 	{
 	public:
 		MultiDrawBuffer()
 		{
-			FirstArray.AddZeroed(1024);
-			CountArray.AddZeroed(1024);
+			ArrayCommands.AddZeroed(1024);
 		}
 
 		MultiDrawBuffer(INT MaxMultiDraw)
 		{
-			FirstArray.AddZeroed(MaxMultiDraw);
-			CountArray.AddZeroed(MaxMultiDraw);
+			ArrayCommands.AddZeroed(MaxMultiDraw);
 		}
 
-		void StartDrawCall() { FirstArray(TotalCommands) = TotalVertices + FirstVertexOffset; }
+		void StartDrawCall() { ArrayCommands(TotalCommands).First = TotalVertices + FirstVertexOffset; }
 
 		void EndDrawCall(INT Vertices)
 		{
-			CountArray(TotalCommands) = Vertices;
+			DrawArraysIndirectCommand& Command = ArrayCommands(TotalCommands);
+			Command.Count			= Vertices;
+			Command.InstanceCount	= 1;
+			Command.BaseInstance	= GetDrawID();
 			TotalVertices += Vertices;
 			TotalCommands++;
+			TotalDrawCalls++;
+			NoteOrder(false);
+		}
+
+		// Queues a draw call that draws one instance of a shared, vertex-less primitive with
+		// @Vertices vertices. Consecutive instances in the same depth sub-batch merge into a
+		// single command because their DrawIDs are consecutive too
+		void AddInstance(INT Vertices)
+		{
+			const INT FirstCommand = TotalDepthBatches ? DepthBatches[TotalDepthBatches - 1].EndCommand : 0;
+			if (TotalCommands > FirstCommand)
+			{
+				DrawArraysIndirectCommand& Prev = ArrayCommands(TotalCommands - 1);
+				if (Prev.Count == static_cast<GLuint>(Vertices) && Prev.First == 0 &&
+					Prev.BaseInstance + Prev.InstanceCount == GetDrawID())
+				{
+					Prev.InstanceCount++;
+					TotalDrawCalls++;
+					return;
+				}
+			}
+
+			DrawArraysIndirectCommand& Command = ArrayCommands(TotalCommands);
+			Command.Count			= Vertices;
+			Command.InstanceCount	= 1;
+			Command.First			= 0;
+			Command.BaseInstance	= GetDrawID();
+			TotalCommands++;
+			TotalDrawCalls++;
+			NoteOrder(false);
+		}
+
+		// Queues one polygon of @NumPts vertices. We write each vertex only once and draw the
+		// polygon as a fan through a static index buffer (see ShaderProgram::CreateFanIndexBuffer)
+		void AddFan(INT NumPts)
+		{
+			if (!FanCommands.Num())
+				FanCommands.AddZeroed(ArrayCommands.Num() * 4);
+
+			DrawElementsIndirectCommand& Command = FanCommands(TotalFans);
+			Command.Count			= (NumPts - 2) * 3;
+			Command.InstanceCount	= 1;
+			Command.FirstIndex		= 0;
+			Command.BaseVertex		= TotalVertices + FirstVertexOffset;
+			Command.BaseInstance	= GetDrawID();
+			TotalVertices += NumPts;
+			TotalFans++;
+			NoteOrder(true);
+		}
+
+		// Ends a draw call that consists of one or more fans
+		void EndFanDrawCall() { TotalDrawCalls++; }
+
+		// Returns true if the last draw call we queued was a streaming draw call in the current depth
+		// sub-batch whose vertices end where the next ones start. ExtendDrawCall can append to it
+		bool CanExtendDrawCall() const
+		{
+			const INT FirstCommand = TotalDepthBatches ? DepthBatches[TotalDepthBatches - 1].EndCommand : 0;
+			if (TotalCommands <= FirstCommand)
+				return false;
+			const DrawArraysIndirectCommand& Prev = ArrayCommands(TotalCommands - 1);
+			return Prev.InstanceCount == 1 && Prev.BaseInstance + 1 == GetDrawID() &&
+				Prev.First + Prev.Count == static_cast<GLuint>(TotalVertices + FirstVertexOffset);
+		}
+
+		// Appends @Vertices vertices to the previous draw call. They are drawn with its DrawID
+		void ExtendDrawCall(INT Vertices)
+		{
+			ArrayCommands(TotalCommands - 1).Count += Vertices;
+			TotalVertices += Vertices;
 		}
 
-		bool IsFull() const { return TotalCommands + 1 >= FirstArray.Num(); }
+		// Same as CanExtendDrawCall, but for draw calls that consist of fans
+		bool CanExtendFanDrawCall() const
+		{
+			const INT FirstFan = TotalDepthBatches ? DepthBatches[TotalDepthBatches - 1].EndFan : 0;
+			return TotalFans > FirstFan && FanCommands(TotalFans - 1).BaseInstance + 1 == GetDrawID();
+		}
+
+		// Queues one more fan for the previous draw call
+		void ExtendFanDrawCall(INT NumPts)
+		{
+			const glm::uint DrawID = FanCommands(TotalFans - 1).BaseInstance;
+			AddFan(NumPts);
+			FanCommands(TotalFans - 1).BaseInstance = DrawID;
+		}
+
+		bool CanBufferFans(INT Fans) const { return !FanCommands.Num() || TotalFans + Fans <= FanCommands.Num(); }
+
+		bool IsFull() const { return TotalDrawCalls + 1 >= ArrayCommands.Num(); }
 
 		void Reset(INT NewFirstVertexOffset = 0, INT NewBaseInstanceOffset = 0)
 		{
-			TotalCommands = TotalVertices = 0;
+			TotalCommands = TotalVertices = TotalStaticCommands = TotalFans = TotalDrawCalls = TotalDepthBatches = TotalOrderBreaks = 0;
+			LastWasFan = false;
 			FirstVertexOffset = NewFirstVertexOffset;
 			BaseInstanceOffset = NewBaseInstanceOffset;
 		}
 
-		glm::uint GetDrawID() const { return TotalCommands + BaseInstanceOffset; }
+		glm::uint GetDrawID() const { return TotalDrawCalls + BaseInstanceOffset; }
 
-		void Draw(GLenum Mode, UXOpenGLRenderDevice* RenDev)
+		// Closes the current depth sub-batch. The draw calls we queued so far will be issued with
+		// @PrevFunc and the ones we queue from now on with @NextFunc. Returns false if the batch
+		// cannot be split, in which case the caller has to flush
+		bool SplitDepthFunc(GLenum PrevFunc, GLenum NextFunc)
 		{
-			if (glMultiDrawArrays)
+			const INT FirstCommand = TotalDepthBatches ? DepthBatches[TotalDepthBatches - 1].EndCommand : 0;
+			const INT FirstFan = TotalDepthBatches ? DepthBatches[TotalDepthBatches - 1].EndFan : 0;
+
+			if (TotalCommands == FirstCommand && TotalFans == FirstFan)
 			{
-				glMultiDrawArrays(Mode, &FirstArray(0), &CountArray(0), TotalCommands);
+				// Nothing was queued with PrevFunc. If we're going back to the depth function of
+				// the previous sub-batch, we can just reopen it
+				if (TotalDepthBatches && DepthBatches[TotalDepthBatches - 1].DepthFunc == NextFunc)
+					TotalDepthBatches--;
+				TailDepthFunc = NextFunc;
+				return true;
+			}
+
+			// Static draw calls are issued after all streaming draw calls, so we can't order them by depth function
+			if (TotalStaticCommands > 0 || TotalDepthBatches == static_cast<INT>(ARRAY_COUNT(DepthBatches)))
+				return false;
+
+			DepthBatch& Batch = DepthBatches[TotalDepthBatches++];
+			Batch.EndCommand	= TotalCommands;
+			Batch.EndFan		= TotalFans;
+			Batch.DepthFunc		= PrevFunc;
+			TailDepthFunc = NextFunc;
+			return true;
+		}
+
+		bool HasDepthBatches() const { return TotalDepthBatches > 0; }
+
+		// Returns true if we can queue @Commands more static draw commands
+		bool CanBufferStatic(INT Commands) const { return TotalStaticCommands + Commands <= (StaticCommands.Num() ? StaticCommands.Num() : ArrayCommands.Num()); }
+
+		// Queues a draw call for vertices that are already resident in a static vertex buffer
+		void AddStaticDrawCall(GLint First, GLsizei Count)
+		{
+			if (!StaticCommands.Num())
+				StaticCommands.AddZeroed(ArrayCommands.Num());
+
+			DrawArraysIndirectCommand& Command = StaticCommands(TotalStaticCommands);
+			Command.Count			= Count;
+			Command.InstanceCount	= 1;
+			Command.First			= First;
+			Command.BaseInstance	= GetDrawID();
+			TotalStaticCommands++;
+			TotalDrawCalls++;
+		}
+
+		// Queues one more range for the static draw call we queued last. It is drawn with the same DrawID
+		void ExtendStaticDrawCall(GLint First, GLsizei Count)
+		{
+			DrawArraysIndirectCommand& Command = StaticCommands(TotalStaticCommands);
+			Command.Count			= Count;
+			Command.InstanceCount	= 1;
+			Command.First			= First;
+			Command.BaseInstance	= StaticCommands(TotalStaticCommands - 1).BaseInstance;
+			TotalStaticCommands++;
+		}
+
+		// Issues the queued streaming draw calls. @DrawIDBuffer is the buffer that backs the DrawID
+		// attribute and @VertexBuffer is the streaming VBO we need to leave bound afterwards
+		void Draw(GLenum Mode, UXOpenGLRenderDevice* RenDev, GLuint DrawIDBuffer, GLuint VertexBuffer)
+		{
+			const bool Indirect = RenDev->UsingIndirectDraws;
+			if (Indirect)
+			{
+				UploadCommands();
 			}
 			else
 			{
-				// Fallback for ancient hardware
-				for (INT i = 0; i < TotalCommands; ++i)
-					glDrawArrays(Mode, FirstArray(i), CountArray(i));
+				// Fallback for devices without base instances
+				if (TotalCommands == 0 && TotalFans == 0)
+					return;
+				glBindBuffer(GL_ARRAY_BUFFER, DrawIDBuffer);
+				if (PerVertexDrawIDs)
+					UploadVertexDrawIDs();
 			}
+
+			// Issue the depth sub-batches in the order we queued them
+			GLuint CurrentDrawID = ~0u;
+			INT FirstCommand = 0, FirstFan = 0, NextBreak = 0;
+			for (INT i = 0; i < TotalDepthBatches; ++i)
+			{
+				RenDev->GLState.SetDepthFunc(DepthBatches[i].DepthFunc);
+				DrawOrdered(Mode, Indirect, CurrentDrawID, NextBreak, FirstCommand, DepthBatches[i].EndCommand, FirstFan, DepthBatches[i].EndFan);
+				FirstCommand = DepthBatches[i].EndCommand;
+				FirstFan = DepthBatches[i].EndFan;
+			}
+			if (TotalDepthBatches > 0)
+				RenDev->GLState.SetDepthFunc(TailDepthFunc);
+			DrawOrdered(Mode, Indirect, CurrentDrawID, NextBreak, FirstCommand, TotalCommands, FirstFan, TotalFans);
+
+			if (Indirect)
+				glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+			else
+				glBindBuffer(GL_ARRAY_BUFFER, VertexBuffer);
+		}
+
+		// Issues the queued static draw calls. The commands were uploaded by Draw
+		void DrawIndirect(GLenum Mode)
+		{
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, IndirectBufferObject);
+			glMultiDrawArraysIndirect(Mode, reinterpret_cast<const GLvoid*>(StaticCommandsOffset), TotalStaticCommands, 0);
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
 		}
 
 		void Cleanup()
 		{
-			// No buffer cleanup needed!
+			if (IndirectBufferObject)
+			{
+				glDeleteBuffers(1, &IndirectBufferObject);
+				IndirectBufferObject = 0;
+			}
+			IndirectRingSize = IndirectRingOffset = 0;
+		}
+
+	private:
+		// Remembers where we switched between unindexed draw calls and fans, so Draw can issue them in the order we queued them
+		void NoteOrder(bool Fan)
+		{
+			if (Fan == LastWasFan)
+				return;
+			LastWasFan = Fan;
+
+			// Nothing to separate from yet
+			if (TotalCommands + TotalFans == 1)
+				return;
+
+			if (TotalOrderBreaks == OrderBreaks.Num())
+				OrderBreaks.AddZeroed(64);
+			OrderBreak& Break = OrderBreaks(TotalOrderBreaks++);
+			Break.EndCommand	= Fan ? TotalCommands : TotalCommands - 1;
+			Break.EndFan		= Fan ? TotalFans - 1 : TotalFans;
+		}
+
+		// Issues streaming commands [FirstCommand, EndCommand) and fans [FirstFan, EndFan), split up at the order breaks they contain.
+		// @NextBreak is the first break we haven't passed yet
+		void DrawOrdered(GLenum Mode, bool Indirect, GLuint& CurrentDrawID, INT& NextBreak, INT FirstCommand, INT EndCommand, INT FirstFan, INT EndFan)
+		{
+			for (; NextBreak < TotalOrderBreaks; ++NextBreak)
+			{
+				const OrderBreak& Break = OrderBreaks(NextBreak);
+				if (Break.EndCommand > EndCommand || Break.EndFan > EndFan)
+					break;
+				DrawRange(Mode, Indirect, CurrentDrawID, FirstCommand, Break.EndCommand, FirstFan, Break.EndFan);
+				FirstCommand = Break.EndCommand;
+				FirstFan = Break.EndFan;
+			}
+			DrawRange(Mode, Indirect, CurrentDrawID, FirstCommand, EndCommand, FirstFan, EndFan);
+		}
+
+		// Issues streaming commands [FirstCommand, EndCommand) and fans [FirstFan, EndFan)
+		void DrawRange(GLenum Mode, bool Indirect, GLuint& CurrentDrawID, INT FirstCommand, INT EndCommand, INT FirstFan, INT EndFan)
+		{
+			if (Indirect)
+			{
+				if (EndCommand > FirstCommand)
+					glMultiDrawArraysIndirect(Mode, reinterpret_cast<const GLvoid*>(ArrayCommandsOffset + FirstCommand * sizeof(DrawArraysIndirectCommand)), EndCommand - FirstCommand, 0);
+				if (EndFan > FirstFan)
+					glMultiDrawElementsIndirect(Mode, GL_UNSIGNED_SHORT, reinterpret_cast<const GLvoid*>(FanCommandsOffset + FirstFan * sizeof(DrawElementsIndirectCommand)), EndFan - FirstFan, 0);
+				return;
+			}
+
+			if (PerVertexDrawIDs)
+			{
+				// The vertices carry their DrawIDs, so we can draw the whole range at once
+				if (EndCommand > FirstCommand)
+				{
+					if (glMultiDrawArrays)
+					{
+						glMultiDrawArrays(Mode, &FirstArray(FirstCommand), &CountArray(FirstCommand), EndCommand - FirstCommand);
+					}
+					else
+					{
+						for (INT i = FirstCommand; i < EndCommand; ++i)
+							glDrawArrays(Mode, FirstArray(i), CountArray(i));
+					}
+				}
+
+				if (EndFan > FirstFan)
+				{
+					if (glMultiDrawElementsBaseVertex)
+					{
+						glMultiDrawElementsBaseVertex(Mode, &FanCountArray(FirstFan), GL_UNSIGNED_SHORT, &FanIndicesArray(FirstFan), EndFan - FirstFan, &FanBaseVertexArray(FirstFan));
+					}
+					else
+					{
+						for (INT i = FirstFan; i < EndFan; ++i)
+							glDrawElementsBaseVertex(Mode, FanCountArray(i), GL_UNSIGNED_SHORT, nullptr, FanBaseVertexArray(i));
+					}
+				}
+				return;
+			}
+
+			// Vertex-less draw calls have nothing to hang a DrawID on. Point the instanced DrawID
+			// attribute straight at the DrawID of every command instead
+			for (INT i = FirstCommand; i < EndCommand; ++i)
+			{
+				const DrawArraysIndirectCommand& Command = ArrayCommands(i);
+				SetDrawIDAttribute(CurrentDrawID, Command.BaseInstance);
+				if (Command.InstanceCount > 1)
+					glDrawArraysInstanced(Mode, Command.First, Command.Count, Command.InstanceCount);
+				else
+					glDrawArrays(Mode, Command.First, Command.Count);
+			}
+
+			for (INT i = FirstFan; i < EndFan; ++i)
+			{
+				const DrawElementsIndirectCommand& Command = FanCommands(i);
+				SetDrawIDAttribute(CurrentDrawID, Command.BaseInstance);
+				glDrawElementsBaseVertex(Mode, Command.Count, GL_UNSIGNED_SHORT, nullptr, Command.BaseVertex);
+			}
+		}
+
+		//
+		// Copies all queued commands into the indirect buffer and leaves it bound. The indirect buffer
+		// is a ring. Every batch gets appended behind the previous one through an unsynchronized
+		// mapping, so we never wait for the GPU. We only orphan the buffer when we wrap around, at
+		// which point the GPU may still read the commands at the start of the ring
+		//
+		void UploadCommands()
+		{
+			const GLsizeiptr ArraysSize = TotalCommands * sizeof(DrawArraysIndirectCommand);
+			const GLsizeiptr FansSize   = TotalFans * sizeof(DrawElementsIndirectCommand);
+			const GLsizeiptr StaticSize = TotalStaticCommands * sizeof(DrawArraysIndirectCommand);
+			const GLsizeiptr Size       = ArraysSize + FansSize + StaticSize;
+
+			if (!IndirectBufferObject)
+				glGenBuffers(1, &IndirectBufferObject);
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, IndirectBufferObject);
+
+			GLbitfield Access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+			if (Size > IndirectRingSize)
+			{
+				// Room for a few full batches
+				IndirectRingSize = Max<GLsizeiptr>(Size, static_cast<GLsizeiptr>(ArrayCommands.Num() * (2 * sizeof(DrawArraysIndirectCommand) + 4 * sizeof(DrawElementsIndirectCommand)))) * 4;
+				glBufferData(GL_DRAW_INDIRECT_BUFFER, IndirectRingSize, nullptr, DRAWCALL_BUFFER_USAGE_PATTERN);
+				IndirectRingOffset = 0;
+			}
+			else if (IndirectRingOffset + Size > IndirectRingSize)
+			{
+				Access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+				IndirectRingOffset = 0;
+			}
+
+			ArrayCommandsOffset  = IndirectRingOffset;
+			FanCommandsOffset    = ArrayCommandsOffset + ArraysSize;
+			StaticCommandsOffset = FanCommandsOffset + FansSize;
+			IndirectRingOffset  += Size;
+			if (!Size)
+				return;
+
+			BYTE* Dest = static_cast<BYTE*>(glMapBufferRange(GL_DRAW_INDIRECT_BUFFER, ArrayCommandsOffset, Size, Access));
+			if (Dest)
+			{
+				if (ArraysSize)
+					appMemcpy(Dest, &ArrayCommands(0), ArraysSize);
+				if (FansSize)
+					appMemcpy(Dest + ArraysSize, &FanCommands(0), FansSize);
+				if (StaticSize)
+					appMemcpy(Dest + ArraysSize + FansSize, &StaticCommands(0), StaticSize);
+				glUnmapBuffer(GL_DRAW_INDIRECT_BUFFER);
+			}
+			else
+			{
+				if (ArraysSize)
+					glBufferSubData(GL_DRAW_INDIRECT_BUFFER, ArrayCommandsOffset, ArraysSize, &ArrayCommands(0));
+				if (FansSize)
+					glBufferSubData(GL_DRAW_INDIRECT_BUFFER, FanCommandsOffset, FansSize, &FanCommands(0));
+				if (StaticSize)
+					glBufferSubData(GL_DRAW_INDIRECT_BUFFER, StaticCommandsOffset, StaticSize, &StaticCommands(0));
+			}
+		}
+
+		//
+		// Fallback for devices without base instances. Writes the DrawID of every queued vertex into
+		// the per-vertex DrawID stream, which must be bound to GL_ARRAY_BUFFER, and converts the
+		// commands into the arrays glMultiDrawArrays and glMultiDrawElementsBaseVertex expect.
+		// The stream is indexed just like the streaming VBO, so we update the same range
+		//
+		void UploadVertexDrawIDs()
+		{
+			const INT EndVertex = FirstVertexOffset + TotalVertices;
+			if (VertexDrawIDs.Num() < EndVertex)
+				VertexDrawIDs.Add(EndVertex - VertexDrawIDs.Num());
+
+			if (FirstArray.Num() < TotalCommands)
+			{
+				FirstArray.Add(TotalCommands - FirstArray.Num());
+				CountArray.Add(TotalCommands - CountArray.Num());
+			}
+			for (INT i = 0; i < TotalCommands; ++i)
+			{
+				const DrawArraysIndirectCommand& Command = ArrayCommands(i);
+				FirstArray(i) = Command.First;
+				CountArray(i) = Command.Count;
+				for (GLuint v = 0; v < Command.Count; ++v)
+					VertexDrawIDs(Command.First + v) = Command.BaseInstance;
+			}
+
+			if (FanCountArray.Num() < TotalFans)
+			{
+				FanCountArray.Add(TotalFans - FanCountArray.Num());
+				FanBaseVertexArray.Add(TotalFans - FanBaseVertexArray.Num());
+				FanIndicesArray.AddZeroed(TotalFans - FanIndicesArray.Num());
+			}
+			for (INT i = 0; i < TotalFans; ++i)
+			{
+				const DrawElementsIndirectCommand& Command = FanCommands(i);
+				FanCountArray(i) = Command.Count;
+				FanBaseVertexArray(i) = Command.BaseVertex;
+				const GLuint NumPts = Command.Count / 3 + 2;
+				for (GLuint v = 0; v < NumPts; ++v)
+					VertexDrawIDs(Command.BaseVertex + v) = Command.BaseInstance;
+			}
+
+			if (TotalVertices > 0)
+			{
+				// stijn: the drivers for these platforms can't deal with the way we use glBufferSubData
+#if MACOSX || __LINUX_ARM__ || __LINUX_ARM64__
+				glBufferData(GL_ARRAY_BUFFER, EndVertex * sizeof(GLuint), &VertexDrawIDs(0), DRAWCALL_BUFFER_USAGE_PATTERN);
+#else
+				glBufferSubData(GL_ARRAY_BUFFER, FirstVertexOffset * sizeof(GLuint), TotalVertices * sizeof(GLuint), &VertexDrawIDs(FirstVertexOffset));
+#endif
+			}
+		}
+
+		static void SetDrawIDAttribute(GLuint& CurrentDrawID, GLuint DrawID)
+		{
+			if (CurrentDrawID == DrawID)
+				return;
+			glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(GLuint), reinterpret_cast<const GLvoid*>(static_cast<size_t>(DrawID) * sizeof(GLuint)));
+			CurrentDrawID = DrawID;
 		}
 
 	public:
-		// OpenGL strictly expects GLint and GLsizei for glMultiDrawArrays
-		TArray<GLint>   FirstArray;
-		TArray<GLsizei> CountArray;
+		// Layouts as specified by ARB_draw_indirect
+		struct DrawArraysIndirectCommand
+		{
+			GLuint Count;
+			GLuint InstanceCount;
+			GLuint First;
+			GLuint BaseInstance;
+		};
+
+		struct DrawElementsIndirectCommand
+		{
+			GLuint Count;
+			GLuint InstanceCount;
+			GLuint FirstIndex;
+			GLint  BaseVertex;
+			GLuint BaseInstance;
+		};
+
+		TArray<DrawArraysIndirectCommand> ArrayCommands;
 
 		INT TotalVertices{};
 		INT TotalCommands{};
+		INT TotalDrawCalls{};		// Number of DrawIDs we have handed out since the last reset
 		INT BaseInstanceOffset{};
 		INT FirstVertexOffset{};
+
+		// Indexed fans. The indices are the same for every fan, so all FirstIndex values are 0
+		TArray<DrawElementsIndirectCommand> FanCommands;
+		INT TotalFans{};
+
+		// Draw calls that reference the static vertex buffer
+		TArray<DrawArraysIndirectCommand> StaticCommands;
+		INT TotalStaticCommands{};
+
+		GLuint IndirectBufferObject{};
+		GLsizeiptr IndirectRingSize{};
+		GLintptr IndirectRingOffset{};
+		GLintptr ArrayCommandsOffset{};
+		GLintptr FanCommandsOffset{};
+		GLintptr StaticCommandsOffset{};
+
+		// Fallback for devices without base instances (see UploadVertexDrawIDs). Vertex-less draw
+		// calls can't use this, so the shader program decides
+		bool PerVertexDrawIDs{};
+		TArray<GLuint> VertexDrawIDs;
+		TArray<GLint> FirstArray;
+		TArray<GLsizei> CountArray;
+		TArray<GLsizei> FanCountArray;
+		TArray<GLint> FanBaseVertexArray;
+		TArray<const void*> FanIndicesArray;	// The indices are the same for every fan, so these are all 0
+
+		// Depth function changes within the batch (see SplitDepthFunc). Every sub-batch ends
+		// where the next one starts. The last one runs up to the end of the batch
+		struct DepthBatch
+		{
+			INT EndCommand;
+			INT EndFan;
+			GLenum DepthFunc;
+		};
+		DepthBatch DepthBatches[16];
+		INT TotalDepthBatches{};
+		GLenum TailDepthFunc{};
+
+		// Points where the batch switches between unindexed draw calls and fans. Between two
+		// breaks, the batch only contains one of the two
+		struct OrderBreak
+		{
+			INT EndCommand;
+			INT EndFan;
+		};
+		TArray<OrderBreak> OrderBreaks;
+		INT TotalOrderBreaks{};
+		bool LastWasFan{};
 	};
 
+	// A range of vertices in a static vertex buffer
+	struct FStaticRange
+	{
+		GLint First;
+		GLsizei Count;
+	};
+
+	// FNV-1a step for the keys of our static geometry caches
+	static void HashStaticValue(QWORD& Hash, DWORD Value)
+	{
+		Hash = (Hash ^ Value) * 1099511628211ULL;
+	}
+
 	//
 	// Shaders
 	//
@@ -1136,6 +1986,7 @@ class UXOpenGLRenderDevice : public URenderDevice
 		No_Prog,
 		Simple_Triangle_Prog,
         Simple_Line_Prog,
+		Simple_Point_Prog,
 		Tile_Prog,
 		PostProcess_Prog,
 		Gouraud_Prog,
@@ -1170,7 +2021,19 @@ class UXOpenGLRenderDevice : public URenderDevice
 			DF_AlphaBlended		= 0x4000,
 
 			// Per-draw call editor state the shader needs to know about
-			DF_Selected			= 0x8000
+			DF_Selected			= 0x8000,
+
+			// The vertices of this draw call come from a static vertex buffer and are in world space
+			DF_StaticGeometry	= 0x10000,
+
+			// Project this draw call with the NearZ projection (HACKFLAGS_NoNearZ)
+			DF_NearZ			= 0x20000,
+
+			// Generate environment mapped UVs from the vertex normals
+			DF_EnvironmentUV	= 0x40000,
+
+			// Transform the diffuse UVs by the texture modifier matrix (227)
+			DF_TexModifier		= 0x80000
 		};
 	};
     
@@ -1203,7 +2066,13 @@ class UXOpenGLRenderDevice : public URenderDevice
 			OPT_ClipDistance         = 0x004000,
 
 			// Enabled editor-specific code
-			OPT_Editor				 = 0x008000
+			OPT_Editor				 = 0x008000,
+
+			// Static BSP geometry is cached in world space
+			OPT_StaticBSPCache		 = 0x010000,
+
+			// Diffuse textures may be layers of the texture array bound to TextureArrayIndex
+			OPT_TextureArrays		 = 0x020000
         };
 
 		ShaderCompilationOptions(DWORD ShaderOptions)
@@ -1282,12 +2151,18 @@ class UXOpenGLRenderDevice : public URenderDevice
         
         // Parameters to be specified by the shader constructor
         INT                                         VertexBufferSize;
+		bool										VertexlessDraws{};	// Our draw calls do not read any vertices. See CreateDrawIDInputLayout
         INT                                         ParametersBufferSize;
         INT                                         ParametersBufferBindingIndex;
         INT                                         NumTextureSamplers;
         GLenum                                      DrawMode;
 		BOOL										UseSSBOParametersBuffer;
 		const DrawCallParameterInfo*				ParametersInfo;		
+
+		// Optional deduplicated material blocks. Shaders that use these must have a MaterialIndex drawcall parameter
+		const DrawCallParameterInfo*				MaterialsInfo{};
+		INT											MaterialsBufferSize{};
+		INT											MaterialsBufferBindingIndex{};
 		ShaderWriterFunc*							VertexShaderFunc;
 		ShaderWriterFunc*							GeoShaderFunc;
 		ShaderWriterFunc*							FragmentShaderFunc;
@@ -1334,6 +2209,9 @@ class UXOpenGLRenderDevice : public URenderDevice
 		// Used to describe the layout of the drawcall parameters		
 		static void EmitDrawCallParametersHeader(const DrawCallParameterInfo* Info, FShaderWriterX& Out, ShaderProgram* Program, INT BufferBindingIndex, bool UseSSBO, bool EmitGetters);
 
+		// Used to describe the layout of the material blocks. The getters take a DrawID and look up the material of the drawcall
+		static void EmitMaterialsHeader(const DrawCallParameterInfo* Info, FShaderWriterX& Out, ShaderProgram* Program, INT BufferBindingIndex, bool UseSSBO);
+
 		// Calculates the maximum size we could use for a uniform struct array whose layout is specified by @Info
 		INT GetMaximumUniformBufferSize(const DrawCallParameterInfo* Info) const;
 
@@ -1356,8 +2234,61 @@ class UXOpenGLRenderDevice : public URenderDevice
 		// Switches away from this shader. This is where we should flush any leftover buffered data and restore global GL state if necessary
 		virtual void DeactivateShader() = 0;
 
-		// Dispatches buffered data. If @Rotate is true, we switch to a different (part of a) vertex and parameters buffer before returning
-		virtual void Flush(bool Rotate = false) = 0;
+		// Dispatches buffered data. If @Rotate is true, we switch to a different (part of a) vertex and parameters buffer before returning.
+		// @Reason is only used for the flush statistics
+		virtual void Flush(bool Rotate, FlushReason Reason) = 0;
+
+		//
+		// Static geometry support. Shaders that cache geometry across frames upload it once
+		// into a static vertex buffer and only stream drawcall parameters afterwards
+		//
+
+		// Allocates a static vertex buffer with room for @NumVertices vertices of @VertexSize bytes each
+		void MapStaticBuffers(INT VertexSize, INT NumVertices);
+
+		// Deallocates the static vertex buffer
+		void UnmapStaticBuffers();
+
+		// Copies vertices into the static vertex buffer and returns the index of the first one.
+		// The caller must make sure the vertices fit
+		INT UploadStaticVertices(const void* Vertices, INT NumVertices);
+
+		// Dispatches the static draw calls in DrawBuffer
+		void DrawStaticGeometry();
+
+		// Binds the input layout for the static vertex buffer
+		virtual void CreateStaticInputLayout() {}
+
+		// Creates the index buffer we use to draw polygons with up to @MaxVertices vertices as
+		// fans, and attaches it to the currently bound VAO
+		void CreateFanIndexBuffer(INT MaxVertices);
+		void DeleteFanIndexBuffer();
+
+		// Forgets about everything we cached in the static vertex buffer
+		virtual void EmptyStaticCache() { NumStaticVertices = 0; }
+
+		// Pushes the material blocks the pending draw calls reference to the GPU
+		virtual void BufferMaterials() {}
+
+		// Switches to a fresh material buffer. Called right after the parameters buffer has rotated
+		virtual void RotateMaterials() {}
+
+		// Sources the DrawID attribute (location 1) of the currently bound VAO from the DrawID buffer.
+		// Vertices do not carry their DrawID. Every draw call draws a single instance instead and
+		// the baseInstance of the call selects the DrawID. Without indirect draws, the DrawID buffer
+		// holds a DrawID for every vertex of the streaming VBO instead
+		void CreateDrawIDInputLayout();
+		void DeleteDrawIDBuffer();
+
+		GLuint										DrawIDBuffer{};
+
+		GLuint										StaticVAO{};
+		GLuint										StaticVertexBuffer{};
+		INT											StaticVertexSize{};
+		INT											StaticVertexBufferSize{};
+		INT											NumStaticVertices{};
+
+		GLuint										FanIndexBuffer{};
 	};
 
 	// Base class for shader implementations
@@ -1381,9 +2312,9 @@ class UXOpenGLRenderDevice : public URenderDevice
 			UnmapBuffers();
 		}		
 
-		virtual void Flush(bool Rotate)
+		virtual void Flush(bool Rotate, FlushReason Reason)
 		{
-			const auto HavePendingData = DrawBuffer.TotalCommands > 0;
+			const auto HavePendingData = DrawBuffer.TotalDrawCalls > 0;
 
 			if (!HavePendingData && !Rotate)
 				return;
@@ -1403,15 +2334,31 @@ class UXOpenGLRenderDevice : public URenderDevice
 
 			if (HavePendingData)
 			{
-				VertBuffer.BufferData(false);
+				STAT(RenDev->Stats.RecordFlush(Reason, DrawBuffer.TotalDrawCalls, VertBuffer.NextElemIndex - VertBuffer.FirstUnbufferedElemIndex));
+
+				// Draw calls that only reference static geometry do not stream any vertices
+				if (VertBuffer.NextElemIndex > VertBuffer.FirstUnbufferedElemIndex)
+					VertBuffer.BufferData(false);
+
+				BufferMaterials();
 
-				// We might have to rebind the parameters buffer here because things like PushClipPlane and
-				// PopClipPlane can temporarily bind another UBO.
+				// Upload the clip planes and fog settings our draw calls reference if they changed since the last flush
+				RenDev->BufferClipPlanes();
+				RenDev->BufferDistanceFog();
+
+				// We might have to rebind the parameters buffer here because things like BufferClipPlanes
+				// can temporarily bind another UBO.
 				ParametersBuffer.Bind();
 				ParametersBuffer.BufferData(false);
 
 				// Issue the draw call
-				DrawBuffer.Draw(DrawMode, RenDev);
+				DrawBuffer.Draw(DrawMode, RenDev, DrawIDBuffer, VertBuffer.BufferObjectName);
+
+				if (DrawBuffer.TotalStaticCommands > 0)
+				{
+					DrawStaticGeometry();
+					VertBuffer.Bind();
+				}
 			}
 
 			if (Rotate)
@@ -1428,6 +2375,8 @@ class UXOpenGLRenderDevice : public URenderDevice
 
 				VertBuffer.Lock();
 				VertBuffer.Rotate(true);
+
+				RotateMaterials();
 			}
 
 			// Reset the multidraw buffer. Note that the Rotate() calls above might simply switch to an
@@ -1448,19 +2397,12 @@ class UXOpenGLRenderDevice : public URenderDevice
 
 		virtual void DeactivateShader()
 		{
-			Flush(false);
+			Flush(false, RenDev->ProgramFlushReason);
 		}
 
 		virtual void MapBuffers()
 		{
-			if (!VertBuffer.Buffer)
-			{
-				VertBuffer.GenerateVertexBuffer(RenDev);
-				VertBuffer.MapVertexBuffer(RenDev->UsingPersistentBuffers, VertexBufferSize);
-				VertBuffer.Bind();
-				CreateInputLayout();
-			}
-
+			// The parameters buffer goes first. Its size determines how many DrawIDs the input layout needs
 			if (!ParametersBuffer.Buffer)
 			{
 				if (UseSSBOParametersBuffer)
@@ -1476,12 +2418,24 @@ class UXOpenGLRenderDevice : public URenderDevice
 					ParametersBuffer.MapUBOBuffer(RenDev->UsingPersistentBuffers, ParametersBufferSize, DRAWCALL_BUFFER_USAGE_PATTERN);
 				}
 			}
+
+			if (!VertBuffer.Buffer)
+			{
+				VertBuffer.GenerateVertexBuffer(RenDev);
+				VertBuffer.MapVertexBuffer(RenDev->UsingPersistentBuffers, VertexBufferSize);
+				VertBuffer.Bind();
+				CreateInputLayout();
+			}
 		}
 
 		virtual void UnmapBuffers()
 		{
 			VertBuffer.DeleteBuffer();
 			ParametersBuffer.DeleteBuffer();
+			DrawBuffer.Cleanup();
+			UnmapStaticBuffers();
+			DeleteFanIndexBuffer();
+			DeleteDrawIDBuffer();
 		}
 
 		// Templated member data
@@ -1496,6 +2450,8 @@ class UXOpenGLRenderDevice : public URenderDevice
 	void InitShaders();
 	INT PrevProgram;
 	INT ActiveProgram;
+	DWORD DeferredPrograms; // Bitmask of inactive programs that still have opaque draw calls buffered
+	FlushReason ProgramFlushReason; // Why SetProgram deactivates the current program. Only used for the flush statistics
 
 	//
 	// Global Shader State
@@ -1511,7 +2467,9 @@ class UXOpenGLRenderDevice : public URenderDevice
 		GouraudParametersIndex			= 7,
 		SimpleLineParametersIndex		= 8,
 		SimpleTriangleParametersIndex	= 9,
-		DistanceFogInfoIndex			= 10
+		DistanceFogInfoIndex			= 10,
+		ComplexMaterialsIndex			= 11,
+		SimplePointParametersIndex		= 12
 	};
 
 	enum TextureIndices
@@ -1524,7 +2482,8 @@ class UXOpenGLRenderDevice : public URenderDevice
 		BumpMapIndex			= 5,
 		EnvironmentMapIndex		= 6,
 		HeightMapIndex			= 7,
-		UploadIndex				= 8
+		UploadIndex				= 8,
+		TextureArrayIndex		= 9
 	};
 
 	// Per-frame state
@@ -1535,6 +2494,7 @@ class UXOpenGLRenderDevice : public URenderDevice
 		glm::mat4 modelMat;
 		glm::mat4 modelviewMat;
 		glm::mat4 modelviewprojMat;
+		glm::mat4 modelviewprojMatNearZ;	// modelviewprojMat with the near plane pulled in for first person weapons
 		glm::mat4 lightSpaceMat;
 		glm::mat4 FrameCoords;
 		glm::mat4 FrameUncoords;
@@ -1559,13 +2519,18 @@ class UXOpenGLRenderDevice : public URenderDevice
 	};
 	BufferObject<LightInfo> LightInfoBuffer;
 
-	// Global ClipPlanes.
-	struct ClipPlaneInfo
+	// Clip plane table. PushClipPlane appends planes here instead of flushing, and every
+	// draw references the contiguous set of planes that was active when it was queued
+	struct ClipPlaneTable
 	{
-		glm::vec4 ClipParams;
-		glm::vec4 ClipPlane;
+		glm::vec4 ClipPlanes[MAX_CLIP_PLANES];
 	};
-	BufferObject<ClipPlaneInfo> GlobalClipPlaneBuffer;
+	BufferObject<ClipPlaneTable> GlobalClipPlaneBuffer;
+	GLuint NumTableClipPlanes{};		// Number of planes we've written into the table since it was last reset
+	GLuint FirstClipPlane{};			// Table index of the bottom plane of the active set
+	GLuint NumEnabledClipDistances{};	// Number of GL_CLIP_DISTANCEi we've enabled
+	DWORD ActiveClipPlanes{};			// Active set as passed to the shaders. FirstClipPlane | (NumClipPlanes << 16)
+	bool ClipPlanesDirty{};
 
 	struct EditorState
 	{
@@ -1574,7 +2539,8 @@ class UXOpenGLRenderDevice : public URenderDevice
 	};
 	BufferObject<EditorState> EditorStateBuffer;
 
-	// Fog
+	// Distance fog table. SetDistanceFog adds the fog settings here instead of flushing, and
+	// every draw references the entry that was active when it was queued. Entry 0 means no fog
 	struct DistanceFogInfo
 	{
 		glm::vec4 FogColor;
@@ -1583,7 +2549,14 @@ class UXOpenGLRenderDevice : public URenderDevice
 		glm::float32 FogDensity;
 		glm::int32 FogMode;
 	};
-	BufferObject<DistanceFogInfo> DistanceFogBuffer;
+	struct DistanceFogTable
+	{
+		DistanceFogInfo DistanceFogs[MAX_DISTANCE_FOGS];
+	};
+	BufferObject<DistanceFogTable> DistanceFogBuffer;
+	INT NumDistanceFogs{};
+	DWORD ActiveDistanceFog{};			// Table index of the active fog settings
+	bool DistanceFogDirty{};
 
 	//
 	// Shader Data Structures
@@ -1594,43 +2567,33 @@ class UXOpenGLRenderDevice : public URenderDevice
 	{
 		glm::vec4		DrawColor;
 		glm::uint64     TexHandles[2]; // mirrored as a uvec4 in GLSL since uint64 is not universally supported
+		glm::vec4       TileCoords;    // view space X, Y of the top left corner, width, height
+		glm::vec4       TileTexCoords; // UV of the top left corner, UV step across the width of the tile
+		glm::vec2       TileTexCoordsY;// UV step down the height of the tile
+		glm::float32    TileZ;
 		glm::uint32     DrawFlags;
+		glm::uint32     ClipPlanes;    // Active clip plane set. See ActiveClipPlanes
 		glm::uint32     Dummy0;
 		glm::uint32     Dummy1;
 		glm::uint32     Dummy2;
 	};
 	static const ShaderProgram::DrawCallParameterInfo DrawTileParametersInfo[];
-	static_assert(sizeof(DrawTileParameters) == 48, "Invalid tile draw parameters size");
-
-	struct DrawTileVertexES
-	{
-		glm::vec3 Coords;
-		glm::uint DrawID;
-		glm::vec2 TexCoords;
-	};
-	static_assert(sizeof(DrawTileVertexES) == 24, "Invalid tile buffered vert size");
-
-	struct DrawTileVertexCore
-	{
-		glm::vec3 Coords;
-		glm::uint DrawID;
-		glm::vec4 TexCoords0;
-		glm::vec4 TexCoords1;
-		glm::vec4 TexCoords2;
-	};
-	static_assert(sizeof(DrawTileVertexCore) == 64, "Invalid tile buffered vert size");
+	static_assert(sizeof(DrawTileParameters) == 96, "Invalid tile draw parameters size");
 
 	// ============================== DRAWSIMPLE ==============================
 	struct DrawSimpleParameters
 	{
-		glm::vec4 DrawColor;
+		glm::uint32 ClipPlanes;
+		glm::float32 PointSize;	// DrawSimplePointProgram only
+		glm::uint32 Dummy0;
+		glm::uint32 Dummy1;
 	};
 	static const ShaderProgram::DrawCallParameterInfo DrawSimpleParametersInfo[];
 
 	struct DrawSimpleVertex
 	{
 		glm::vec3 Coords;
-		glm::uint DrawID;
+		glm::uint Color;		// RGBA8
 	};
 	static_assert(sizeof(DrawSimpleVertex) == 16, "Invalid simple buffered vert size");
 
@@ -1642,31 +2605,47 @@ class UXOpenGLRenderDevice : public URenderDevice
 		glm::vec4 MiscInfo;				// BumpMap Specular, Gamma
 		glm::vec4 DrawColor;
 		glm::uint64 TexHandles[8];		// mirrored as 4 uvec4s
+		glm::vec4 TexModifier[2];		// 2x3 UV transform rows. Only valid with DF_TexModifier
 		glm::uint32 DrawFlags;
-		glm::uint32 Dummy0;
-		glm::uint32 Dummy1;
+		glm::uint32 ClipPlanes;
+		glm::uint32 DistanceFog;
 		glm::uint32 Dummy2;
 	};
 	static const ShaderProgram::DrawCallParameterInfo DrawGouraudParametersInfo[];
-	static_assert(sizeof(DrawGouraudParameters) == 144, "Invalid complex drawcall parameters size");
+	static_assert(sizeof(DrawGouraudParameters) == 176, "Invalid complex drawcall parameters size");
 
 	struct DrawGouraudVertex
 	{
 		glm::vec3 Coords;
-		glm::uint DrawID;
-		glm::vec4 Normals;
-		glm::vec2 TexCoords;
-		glm::vec4 LightColor;
-		glm::vec4 FogColor;
+		glm::uint Normals;		// GL_INT_2_10_10_10_REV
+		glm::vec2 TexCoords;	// not in texture space yet so these need full precision
+		glm::uint64 LightColor;	// RGBA16F
+		glm::uint64 FogColor;	// RGBA16F
 	};
-	static_assert(sizeof(DrawGouraudVertex) == 72, "Invalid gouraud buffered vertex size");
+	static_assert(sizeof(DrawGouraudVertex) == 40, "Invalid gouraud buffered vertex size");
 
 	// ============================== DRAWCOMPLEX ==============================
+	// Per-surface data
 	struct DrawComplexParameters
 	{
-		glm::vec4 DiffuseUV;
 		glm::vec4 LightMapUV;
 		glm::vec4 FogMapUV;
+		glm::vec4 XAxis;
+		glm::vec4 YAxis;
+		glm::vec4 ZAxis;
+		glm::uint64 LightFogHandles[2]; // mirrored as a uvec4
+		glm::uint32 MaterialIndex;
+		glm::uint32 DrawFlags;
+		glm::uint32 ClipPlanes;
+		glm::uint32 DistanceFog;
+	};
+	static const ShaderProgram::DrawCallParameterInfo DrawComplexParametersInfo[];
+	static_assert(sizeof(DrawComplexParameters) == 112, "Invalid complex drawcall parameters size");
+
+	// Texture data that is usually shared by many surfaces. We store every distinct material only once per buffer
+	struct DrawComplexMaterial
+	{
+		glm::vec4 DiffuseUV;
 		glm::vec4 DetailUV;
 		glm::vec4 MacroUV;
 		glm::vec4 EnviroMapUV;
@@ -1674,26 +2653,18 @@ class UXOpenGLRenderDevice : public URenderDevice
 		glm::vec4 MacroInfo;
 		glm::vec4 BumpMapInfo;
 		glm::vec4 HeightMapInfo;
-		glm::vec4 XAxis;
-		glm::vec4 YAxis;
-		glm::vec4 ZAxis;
 		glm::vec4 DrawColor;
-		glm::uint64 TexHandles[8]; // mirrored as 4 uvec2s
-		glm::uint32 DrawFlags;
-		glm::uint32 Dummy0;
-		glm::uint32 Dummy1;
-		glm::uint32 Dummy2;
+		glm::vec4 DiffuseModifier[2]; // 2x3 UV transform rows. Only valid with DF_TexModifier
+		glm::uint64 TexHandles[8]; // mirrored as 4 uvec4s. The lightmap and fogmap slots are unused
 	};
-	static const ShaderProgram::DrawCallParameterInfo DrawComplexParametersInfo[];
-	static_assert(sizeof(DrawComplexParameters) == 304, "Invalid complex drawcall parameters size");
+	static const ShaderProgram::DrawCallParameterInfo DrawComplexMaterialInfo[];
+	static_assert(sizeof(DrawComplexMaterial) == 240, "Invalid complex material size");
 
 	struct DrawComplexVertex
 	{
 		glm::vec3 Coords;
-		glm::uint DrawID;
-		glm::vec4 Normal;
 	};
-	static_assert(sizeof(DrawComplexVertex) == 32, "Invalid complex buffered vertex size");
+	static_assert(sizeof(DrawComplexVertex) == 12, "Invalid complex buffered vertex size");
 
 	// ============================== NOPROGRAM ==============================
 	struct NoParameters
@@ -1709,67 +2680,73 @@ class UXOpenGLRenderDevice : public URenderDevice
 	//
 	// DrawTile Shaders
 	//
-	class DrawTileCoreProgram : public ShaderProgramImpl<DrawTileVertexCore, DrawTileParameters>
+	// Tiles do not stream any vertices. Every tile is an instance of a unit quad whose
+	// rectangle and UVs the vertex shader fetches from the draw call parameters
+	class DrawTileProgram : public ShaderProgramImpl<NoVertex, DrawTileParameters>
 	{
 	public:
-		DrawTileCoreProgram(const TCHAR* Name, UXOpenGLRenderDevice* RenDev);
-		void CreateInputLayout();	
+		DrawTileProgram(const TCHAR* Name, UXOpenGLRenderDevice* RenDev);
+		void CreateInputLayout();
 		void ActivateShader();
 		void DeactivateShader();
 
 		static void BuildVertexShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out);
-		static void BuildGeometryShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out);
 		static void BuildFragmentShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out);
 
 		BOOL DepthTesting;		
 	};
 
-	// Used for ES _and_ for Core (w/ geo shaders disabled)!
-	class DrawTileESProgram : public ShaderProgramImpl<DrawTileVertexES, DrawTileParameters>
+	//
+	// DrawSimple Shaders
+	//
+	// Lines, points and screen flashes. The colors are stored per vertex, so consecutive primitives
+	// with the same draw call parameters are appended to the same draw call
+	class DrawSimpleProgram : public ShaderProgramImpl<DrawSimpleVertex, DrawSimpleParameters>
 	{
 	public:
-		DrawTileESProgram(const TCHAR* Name, UXOpenGLRenderDevice* RenDev);
+		DrawSimpleProgram(const TCHAR* Name, UXOpenGLRenderDevice* RenDev);
 		void CreateInputLayout();
 		void ActivateShader();
 		void DeactivateShader();
 
-		static void BuildVertexShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out);
-		static void BuildFragmentShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out);
+		// Returns where to write the vertices of the next primitive. EndPrimitive queues them
+		DrawSimpleVertex* BeginPrimitive(const DrawSimpleParameters& Params);
+		void EndPrimitive(INT NumVerts);
 
-		BOOL DepthTesting;		
+		glm::uint OldLineFlags;
+		glm::uint OldBlendMode;
+		DrawSimpleParameters LastParams{};
+		bool ExtendingDrawCall{};
 	};
 
-	//
-	// DrawSimple Shaders
-	//
-	class DrawSimpleLineProgram : public ShaderProgramImpl<DrawSimpleVertex, DrawSimpleParameters>
+	class DrawSimpleLineProgram : public DrawSimpleProgram
 	{
 	public:
 		DrawSimpleLineProgram(const TCHAR* Name, UXOpenGLRenderDevice* RenDev);
-		void CreateInputLayout();
-		void ActivateShader();
-		void DeactivateShader();
 
 		static void BuildVertexShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out);
 		static void BuildFragmentShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out);
-
-		glm::uint OldLineFlags;
-		glm::uint OldBlendMode;		
 	};
 
-	class DrawSimpleTriangleProgram : public ShaderProgramImpl<DrawSimpleVertex, DrawSimpleParameters>
+	class DrawSimpleTriangleProgram : public DrawSimpleProgram
 	{
 	public:
 		DrawSimpleTriangleProgram(const TCHAR* Name, UXOpenGLRenderDevice* RenDev);
-		void CreateInputLayout();
-		void ActivateShader();
-		void DeactivateShader();
 
 		static void BuildVertexShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out);
 		static void BuildFragmentShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out);
+	};
 
-		glm::uint OldLineFlags;
-		glm::uint OldBlendMode;
+	// Square Draw2DPoints. The vertex shader sets gl_PointSize
+	class DrawSimplePointProgram : public DrawSimpleProgram
+	{
+	public:
+		DrawSimplePointProgram(const TCHAR* Name, UXOpenGLRenderDevice* RenDev);
+
+		static void BuildVertexShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out);
+		static void BuildFragmentShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out);
+
+		FLOAT MaxPointSize;
 	};
 
 	//
@@ -1780,15 +2757,65 @@ class UXOpenGLRenderDevice : public URenderDevice
 	public:
 		DrawGouraudProgram(const TCHAR* Name, UXOpenGLRenderDevice* RenDev);
 		void CreateInputLayout();
+		void CreateStaticInputLayout();
+		void MapBuffers();
+		void EmptyStaticCache();
+		void DeactivateShader();
 
 		static void BuildVertexShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out);
 		static void BuildGeometryShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out);
 		static void BuildFragmentShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out);
 
+		// Mesh buffering
+		struct FMeshEntry
+		{
+			FStaticRange Range;		// Range.First is INDEX_NONE for candidates we have not uploaded yet
+			INT Next;				// Next entry with the same key
+			INT Copy;				// Index of our copy of the vertices in MeshCopies
+			DWORD Frame;			// Frame in which we last recorded the candidate
+		};
+		struct FMeshMisses
+		{
+			INT Count;				// Consecutive lookups that did not match any entry of the key
+			DWORD Frame;			// Frame of the last miss
+		};
+		enum
+		{
+			MESH_MAX_MISSES		= 8,	// Keys that miss this often in a row skip the cache...
+			MESH_MISS_BACKOFF	= 128	// ... for this many frames
+		};
+		const FStaticRange* CacheMesh(FSceneNode* Frame, FTextureInfo& Info, FTransTexture* Pts, INT NumPts, DWORD PolyFlags);
+		void BuildMeshVerts(FSceneNode* Frame, FTransTexture* Pts, INT NumPts);
+		bool MatchesMeshCopy(const FMeshEntry& Entry, FTransTexture* Pts);
+		void ResetMeshCache();
+
+		// PrepareGouraudCall fills in PendingParams. WritePendingParams moves them into the parameters
+		// buffer. We keep a copy of the last parameters we wrote, so we can append polygons that have
+		// the same parameters to the previous draw call instead
+		void WritePendingParams()
+		{
+			memcpy(ParametersBuffer.GetCurrentElementPtr(), &PendingParams, sizeof(DrawGouraudParameters));
+			LastParams = PendingParams;
+		}
+		bool PendingParamsMatchLast() const { return appMemcmp(&PendingParams, &LastParams, sizeof(DrawGouraudParameters)) == 0; }
+
+		DrawGouraudParameters PendingParams{};
+		DrawGouraudParameters LastParams{};
+
 		// Cached Texture Infos
 		FTEXTURE_PTR DetailTextureInfo{};
 		FTEXTURE_PTR MacroTextureInfo{};
 		FTEXTURE_PTR BumpMapInfo{};
+		DWORD LockedTextureFlags{};	// Draw flags of the texture infos above we have to unlock
+
+		// Meshes we have uploaded into the static vertex buffer, and candidates we might upload later.
+		// MeshBuckets maps the key of a mesh to the first entry of its chain
+		TOpenGLMap<QWORD, INT> MeshBuckets;
+		TOpenGLMap<QWORD, FMeshMisses> MeshMisses;
+		TArray<FMeshEntry> MeshEntries;
+		TArray<DrawGouraudVertex> MeshCopies;
+		TArray<FVector> StaticMeshPoints;
+		TArray<DrawGouraudVertex> StaticMeshVerts;
 	};
 
 	//
@@ -1799,12 +2826,35 @@ class UXOpenGLRenderDevice : public URenderDevice
 	public:
 		DrawComplexProgram(const TCHAR* Name, UXOpenGLRenderDevice* RenDev);
 		void CreateInputLayout();
+		void CreateStaticInputLayout();
+		void MapBuffers();
+		void UnmapBuffers();
+		void EmptyStaticCache();
+		void BufferMaterials();
+		void RotateMaterials();
 
 		static void BuildVertexShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out);
 		static void BuildFragmentShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out);
 
+		// Returns the index of @Material in the materials buffer, adding it if we have not seen it since the last rotation
+		glm::uint AddMaterial(const DrawComplexMaterial& Material);
+
+		BufferObject<DrawComplexMaterial> MaterialsBuffer;
+		TArray<DrawComplexMaterial> Materials;		// CPU copy of the active sub-buffer. Persistent mappings are slow to read back
+		TOpenGLMap<QWORD, INT> MaterialIndices;		// Material hash -> index in Materials
+
+		// Static BSP geometry cache. Fills StaticFacetRanges, or returns false if the facet has to be streamed
+		bool CacheStaticFacet(FSceneNode* Frame, FSurfaceFacet& Facet);
+
 		// Cached texture Info
 		FTEXTURE_PTR BumpMapInfo{};
+
+		// Triangulated BSP nodes we have already uploaded into the static vertex buffer, indexed by node.
+		// Count is 0 for nodes we have not uploaded. StaticModel is the BSP the nodes belong to
+		TArray<FStaticRange> StaticNodes;
+		UModel* StaticModel{};
+		TArray<FStaticRange> StaticFacetRanges;		// Ranges of the facet we are drawing. Adjacent ranges are merged
+		TArray<glm::vec3> StaticFacetVerts;
 	};
 
 	//
@@ -1814,7 +2864,7 @@ class UXOpenGLRenderDevice : public URenderDevice
 	{
 	public:
 		NoProgram(const TCHAR* Name, UXOpenGLRenderDevice* RenDev);
-		void Flush(bool Rotate);
+		void Flush(bool Rotate, FlushReason Reason);
 		void CreateInputLayout();
 		void MapBuffers();
 		void UnmapBuffers();
@@ -1826,7 +2876,7 @@ class UXOpenGLRenderDevice : public URenderDevice
 	{
 	public:
 		PostProcessProgram(const TCHAR* Name, UXOpenGLRenderDevice* RenDev);
-		void Flush(bool Rotate);
+		void Flush(bool Rotate, FlushReason Reason);
 		void CreateInputLayout();
 		void MapBuffers();
 		void UnmapBuffers();
@@ -1890,6 +2940,10 @@ class UXOpenGLRenderDevice : public URenderDevice
 #endif
 	BYTE  PushClipPlane(const FPlane& Plane);
 	BYTE  PopClipPlane();
+	void  ResetClipPlanes();
+	void  BufferClipPlanes();
+	void  EmptyDistanceFogTable();
+	void  BufferDistanceFog();
 	BYTE  SetZTestMode(BYTE Mode);
 
 	//
@@ -1897,6 +2951,8 @@ class UXOpenGLRenderDevice : public URenderDevice
 	//
 	DWORD PrepareGouraudCall(FSceneNode* Frame, FTextureInfo& Info, DWORD PolyFlags);
 	void FinishGouraudCall(FTextureInfo& Info, DWORD DrawFlags);
+	void BenchmarkGouraudVerts(FOutputDevice& Ar);
+	void BenchmarkTextureLookups(FOutputDevice& Ar);
 	void PrepareSimpleCall(ShaderProgram* Shader, glm::uint& OldLineFlags, glm::uint LineFlags, glm::uint& OldBlendMode, glm::uint BlendMode);
 
 	//
@@ -1949,11 +3005,16 @@ class UXOpenGLRenderDevice : public URenderDevice
 	// OpenGL Context State Management
 	//
 	void  MakeCurrent();
+	void  ParallelFor(INT Count, INT MinPerJob, FGLJobFunc Func, void* Context);
 	void  UpdateCoords(FSceneNode* Frame);
 	void  SetOrthoProjection(FSceneNode* Frame);
-	void  SetProjection(FSceneNode* Frame, UBOOL bNearZ);
+	void  SetProjection(FSceneNode* Frame);
 	void  SetPermanentState();
-	void  SetProgram(INT CurrentProgram);
+	void  SetProgram(INT CurrentProgram, FlushReason Reason = Flush_Program);
+	bool  CanDeferProgram(INT Program) const;
+	void  FlushDeferredPrograms(FlushReason Reason);
+	void  FlushPendingDraws(FlushReason Reason);
+	void  SetGouraudCulling(GLenum Face);
 #if UNREAL_OLDUNREAL
 	void  SetDistanceFog(FFogSurf& Surf);
 #endif
@@ -1965,9 +3026,18 @@ class UXOpenGLRenderDevice : public URenderDevice
 	//
 	static BOOL WillBlendStateChange(DWORD OldPolyFlags, DWORD NewPolyFlags);
 	BOOL  WillTextureStateChange(INT Multi, FTextureInfo& Info, DWORD PolyFlags);
-	FCachedTexture* GetCachedTextureInfo(INT Multi, FTextureInfo& Info, DWORD PolyFlags, BOOL& IsResidentBindlessTexture, BOOL& IsBoundToTMU, BOOL& IsTextureDataStale, BOOL ShouldResetStaleState);
-	void  SetTexture(INT Multi, FTextureInfo& Info, DWORD PolyFlags, FLOAT PanBias);
+	BOOL  CheckTexture(INT Multi, FTextureInfo& Info, DWORD PolyFlags, FResolvedTexture& Resolved);
+	FCachedTexture* FindCachedTexture(QWORD CacheID);
+	FCachedTexture& AddCachedTexture(QWORD CacheID);
+	FCachedTexture* GetCachedTextureInfo(INT Multi, FTextureInfo& Info, DWORD PolyFlags, BOOL& IsResidentBindlessTexture, BOOL& IsBoundToTMU, BOOL& IsTextureDataStale, BOOL ShouldResetStaleState, const FResolvedTexture* Resolved=nullptr);
+	void  SetTexture(INT Multi, FTextureInfo& Info, DWORD PolyFlags, FLOAT PanBias, const FResolvedTexture* Resolved=nullptr);
 	void  SetNoTexture(INT Multi);
+	UBOOL SetTextureFromLookup(INT Multi, UTexture* Texture);
+	void  AddTextureLookup(INT Multi, UTexture* Texture, FTextureInfo& Info);
+	void  ResetTextureLookups();
+#if ENGINE_VERSION==227
+	bool  GetTexModifier(FTextureInfo& Info, glm::vec4* Rows);
+#endif
 	DWORD GetPolyFlagsAndDrawFlags(DWORD PolyFlags, DWORD& DrawFlags, BOOL RemoveOccludeIfSolid);
 	void  SetBlend(DWORD PolyFlags);
 	DWORD SetDepth(DWORD LineFlags);
@@ -1975,6 +3045,14 @@ class UXOpenGLRenderDevice : public URenderDevice
 	BOOL  UploadTexture(FTextureInfo& Info, FCachedTexture* Bind, DWORD PolyFlags, BOOL IsFirstUpload, BOOL IsBindlessTexture, BOOL PartialUpload=FALSE, INT U=0, INT V=0, INT UL=0, INT VL=0, BYTE* TextureData=nullptr);
 	void  GenerateTextureAndSampler(FCachedTexture* Bind);
 	void  BindTextureAndSampler(INT Multi, FCachedTexture* Bind);
+	FTileAtlasEntry* GetTileAtlasEntry(FTextureInfo& Info, DWORD PolyFlags, FLOAT U, FLOAT V, FLOAT UL, FLOAT VL);
+	BOOL  WillTileAtlasStateChange(FTileAtlasEntry* Entry, DWORD PolyFlags);
+	void  SetTileAtlasTexture(FTileAtlasEntry* Entry, FTextureInfo& Info, DWORD PolyFlags);
+	void  EmptyTileAtlas();
+	void  DeleteTileAtlas();
+	BOOL  SetTextureArrayLayer(FTextureInfo& Info, FCachedTexture*& Bind, DWORD PolyFlags, BOOL IsTextureDataStale);
+	BOOL  UploadTextureArrayLayer(FTextureInfo& Info, FCachedTexture* Bind, DWORD PolyFlags);
+	void  DeleteTexturePools();
 
 	//
 	// Gamma Control
@@ -18,6 +18,11 @@
 	Helpers
 -----------------------------------------------------------------------------*/
 
+static glm::vec4 GetTextureInfo(UTexture* Texture)
+{
+	return glm::vec4(Texture->Diffuse > 0.f ? Texture->Diffuse : 1.f, Texture->Specular, Texture->Alpha > 0.f ? Texture->Alpha : 1.f, Texture->TEXTURE_SCALE_NAME);
+}
+
 static void SetTextureHelper
 (
 	UXOpenGLRenderDevice* RenDev,
@@ -29,14 +34,15 @@ static void SetTextureHelper
 	FLOAT PanBias,
 	glm::vec4* TextureCoords,
 	glm::vec4* TextureInfo,
-	glm::uint64* TexHandles
+	glm::uint64* TexHandles,
+	const UXOpenGLRenderDevice::FResolvedTexture* Resolved=nullptr
 )
 {
-	RenDev->SetTexture(Multi, Info, PolyFlags, PanBias);
+	RenDev->SetTexture(Multi, Info, PolyFlags, PanBias, Resolved);
 	if (TextureCoords)
 		*TextureCoords = glm::vec4(RenDev->TexInfo[Multi].UMult, RenDev->TexInfo[Multi].VMult, RenDev->TexInfo[Multi].UPan, RenDev->TexInfo[Multi].VPan);
 	if (TextureInfo)
-		*TextureInfo = glm::vec4(Info.Texture->Diffuse > 0.f ? Info.Texture->Diffuse : 1.f, Info.Texture->Specular, Info.Texture->Alpha > 0.f ? Info.Texture->Alpha : 1.f, Info.Texture->TEXTURE_SCALE_NAME);
+		*TextureInfo = GetTextureInfo(Info.Texture);
 	TexHandles[Multi] = RenDev->TexInfo[Multi].BindlessTexHandle;
 	DrawFlags |= AddDrawFlag;
 }
@@ -65,24 +71,41 @@ void UXOpenGLRenderDevice::DrawComplexSurface(FSceneNode* Frame, FSurfaceInfo& S
 	if (GIsEditor && NextPolyFlags & PF_Selected)
 		DrawFlags |= ShaderDrawFlags::DF_Selected;
 
-	const bool CanBuffer = !Shader->DrawBuffer.IsFull() && Shader->ParametersBuffer.CanBuffer(1);
+	// Look up or upload the facet's static geometry before we write any drawcall parameters. This may have to flush
+	const bool StaticFacet = UsingStaticBSPCache && Shader->CacheStaticFacet(Frame, Facet);
+	if (StaticFacet)
+		DrawFlags |= ShaderDrawFlags::DF_StaticGeometry;
+
+	const bool CanBuffer = !Shader->DrawBuffer.IsFull() && Shader->ParametersBuffer.CanBuffer(1) && Shader->MaterialsBuffer.CanBuffer(1) &&
+		(!StaticFacet || Shader->DrawBuffer.CanBufferStatic(Shader->StaticFacetRanges.Num()));
 
 	// Check if this draw call will change any global state. If so, we want to flush any pending draw calls before we make the changes
-	if (WillBlendStateChange(CurrentBlendPolyFlags, NextPolyFlags) || // Check if the blending mode will change
-		WillTextureStateChange(DiffuseTextureIndex, *Surface.Texture, NextPolyFlags) || // Check if the surface textures will change
-		(Surface.LightMap && WillTextureStateChange(LightMapIndex, *Surface.LightMap, NextPolyFlags)) ||
-		((Surface.FogMap && Surface.FogMap->Mips[0] && Surface.FogMap->Mips[0]->DataPtr) && WillTextureStateChange(FogMapIndex, *Surface.FogMap, NextPolyFlags)) ||
-		(Surface.DetailTexture && DetailTextures && WillTextureStateChange(DetailTextureIndex, *Surface.DetailTexture, NextPolyFlags)) ||
-		(Surface.MacroTexture && MacroTextures && WillTextureStateChange(MacroTextureIndex, *Surface.MacroTexture, NextPolyFlags)) ||
+	// The texture checks use the same PolyFlags as the SetTexture calls below, so those can reuse the lookups
+	FResolvedTexture Resolved[ARRAY_COUNT(TexInfo)];
+	appMemzero(Resolved, sizeof(Resolved));
+	const bool HasFogMap = Surface.FogMap && Surface.FogMap->Mips[0] && Surface.FogMap->Mips[0]->DataPtr;
+	FlushReason Reason = Flush_None;
+	if (!CanBuffer)
+		Reason = Flush_BufferFull;
+	else if (WillBlendStateChange(CurrentBlendPolyFlags, NextPolyFlags)) // Check if the blending mode will change
+		Reason = Flush_Blend;
+	else if (CheckTexture(DiffuseTextureIndex, *Surface.Texture, NextPolyFlags, Resolved[DiffuseTextureIndex]) || // Check if the surface textures will change
+		(Surface.LightMap && CheckTexture(LightMapIndex, *Surface.LightMap, PF_None, Resolved[LightMapIndex])) ||
+		(HasFogMap && CheckTexture(FogMapIndex, *Surface.FogMap, PF_AlphaBlend, Resolved[FogMapIndex])) ||
+		(Surface.DetailTexture && DetailTextures && CheckTexture(DetailTextureIndex, *Surface.DetailTexture, PF_None, Resolved[DetailTextureIndex])) ||
+		(Surface.MacroTexture && MacroTextures && CheckTexture(MacroTextureIndex, *Surface.MacroTexture, PF_None, Resolved[MacroTextureIndex]))
 #if ENGINE_VERSION==227
-		(Surface.BumpMap && BumpMaps && WillTextureStateChange(BumpMapIndex, *Surface.BumpMap, NextPolyFlags)) ||
-		(Surface.EnvironmentMap && EnvironmentMaps && WillTextureStateChange(EnvironmentMapIndex, *Surface.EnvironmentMap, NextPolyFlags)) ||
-		(Surface.HeightMap && WillTextureStateChange(HeightMapIndex, *Surface.HeightMap, NextPolyFlags)) ||
+		|| (Surface.BumpMap && BumpMaps && CheckTexture(BumpMapIndex, *Surface.BumpMap, PF_None, Resolved[BumpMapIndex]))
+		|| (Surface.EnvironmentMap && EnvironmentMaps && CheckTexture(EnvironmentMapIndex, *Surface.EnvironmentMap, PF_None, Resolved[EnvironmentMapIndex]))
+		|| (Surface.HeightMap && CheckTexture(HeightMapIndex, *Surface.HeightMap, PF_None, Resolved[HeightMapIndex]))
 #endif
-		!CanBuffer)
+		)
+		Reason = Flush_Texture;
+
+	if (Reason != Flush_None)
 	{
 		// Dispatch buffered data
-		Shader->Flush(!CanBuffer);
+		Shader->Flush(!CanBuffer, Reason);
 
 		// Update global GL state
 		SetBlend(NextPolyFlags);
@@ -90,49 +113,73 @@ void UXOpenGLRenderDevice::DrawComplexSurface(FSceneNode* Frame, FSurfaceInfo& S
 
 	DrawComplexParameters* DrawCallParams = Shader->ParametersBuffer.GetCurrentElementPtr();
 
+	// Build the material in local memory first so we can check if the materials buffer already has it
+	DrawComplexMaterial Material;
+	appMemzero(&Material, sizeof(Material));
+
 	// Editor Support.
 	if (GIsEditor)
-		DrawCallParams->DrawColor = HitTesting() ? FPlaneToVec4(HitColor) : FPlaneToVec4(Surface.FlatColor.Plane());
+		Material.DrawColor = HitTesting() ? FPlaneToVec4(HitColor) : FPlaneToVec4(Surface.FlatColor.Plane());
 
 	// Set Textures
-	SetTextureHelper(this, DiffuseTextureIndex, *Surface.Texture, NextPolyFlags, DrawFlags, ShaderDrawFlags::DF_DiffuseTexture, 0.0, &DrawCallParams->DiffuseUV, Surface.Texture->Texture ? &DrawCallParams->DiffuseInfo : nullptr, DrawCallParams->TexHandles);
+	SetTextureHelper(this, DiffuseTextureIndex, *Surface.Texture, NextPolyFlags, DrawFlags, ShaderDrawFlags::DF_DiffuseTexture, 0.0, &Material.DiffuseUV, Surface.Texture->Texture ? &Material.DiffuseInfo : nullptr, Material.TexHandles, &Resolved[DiffuseTextureIndex]);
 	if (!Surface.Texture->Texture)
-		DrawCallParams->DiffuseInfo = glm::vec4(1.f, 0.f, 0.f, 1.f);
+		Material.DiffuseInfo = glm::vec4(1.f, 0.f, 0.f, 1.f);
+#if ENGINE_VERSION==227
+	if (GetTexModifier(*Surface.Texture, Material.DiffuseModifier))
+		DrawFlags |= ShaderDrawFlags::DF_TexModifier;
+#endif
 
 	if (Surface.LightMap)
-		SetTextureHelper(this, LightMapIndex, *Surface.LightMap, PF_None, DrawFlags, ShaderDrawFlags::DF_LightMap, -0.5, &DrawCallParams->LightMapUV, nullptr, DrawCallParams->TexHandles);
+		SetTextureHelper(this, LightMapIndex, *Surface.LightMap, PF_None, DrawFlags, ShaderDrawFlags::DF_LightMap, -0.5, &DrawCallParams->LightMapUV, nullptr, Material.TexHandles, &Resolved[LightMapIndex]);
 
-	if (Surface.FogMap && Surface.FogMap->Mips[0] && Surface.FogMap->Mips[0]->DataPtr)
-		SetTextureHelper(this, FogMapIndex, *Surface.FogMap, PF_AlphaBlend, DrawFlags, ShaderDrawFlags::DF_FogMap, -0.5, &DrawCallParams->FogMapUV, nullptr, DrawCallParams->TexHandles);
+	if (HasFogMap)
+		SetTextureHelper(this, FogMapIndex, *Surface.FogMap, PF_AlphaBlend, DrawFlags, ShaderDrawFlags::DF_FogMap, -0.5, &DrawCallParams->FogMapUV, nullptr, Material.TexHandles, &Resolved[FogMapIndex]);
 
 	if (Surface.DetailTexture && DetailTextures)
-		SetTextureHelper(this, DetailTextureIndex, *Surface.DetailTexture, PF_None, DrawFlags, ShaderDrawFlags::DF_DetailTexture, 0.0, &DrawCallParams->DetailUV, nullptr, DrawCallParams->TexHandles);
+		SetTextureHelper(this, DetailTextureIndex, *Surface.DetailTexture, PF_None, DrawFlags, ShaderDrawFlags::DF_DetailTexture, 0.0, &Material.DetailUV, nullptr, Material.TexHandles, &Resolved[DetailTextureIndex]);
 
 	if (Surface.MacroTexture && MacroTextures)
-		SetTextureHelper(this, MacroTextureIndex, *Surface.MacroTexture, PF_None, DrawFlags, ShaderDrawFlags::DF_MacroTexture, 0.0, &DrawCallParams->MacroUV, &DrawCallParams->MacroInfo, DrawCallParams->TexHandles);
+		SetTextureHelper(this, MacroTextureIndex, *Surface.MacroTexture, PF_None, DrawFlags, ShaderDrawFlags::DF_MacroTexture, 0.0, &Material.MacroUV, &Material.MacroInfo, Material.TexHandles, &Resolved[MacroTextureIndex]);
 
 #if ENGINE_VERSION==227
 	if (Surface.BumpMap && BumpMaps)
 	{
 		Shader->BumpMapInfo = Surface.BumpMap;
+		SetTextureHelper(this, BumpMapIndex, FTEXTURE_GET(Shader->BumpMapInfo), PF_None, DrawFlags, ShaderDrawFlags::DF_BumpMap, 0.0, nullptr, &Material.BumpMapInfo, Material.TexHandles, &Resolved[BumpMapIndex]);
+	}
 #else
+	// The engine doesn't resolve bump maps for us, so we only lock them once per frame
+	UBOOL BumpMapLocked = FALSE;
 	if (BumpMaps && Surface.Texture && Surface.Texture->Texture && Surface.Texture->Texture->BumpMap)
 	{
+		UTexture* BumpMap = Surface.Texture->Texture->BumpMap;
+		if (SetTextureFromLookup(BumpMapIndex, BumpMap))
+		{
+			Material.BumpMapInfo = GetTextureInfo(BumpMap);
+			Material.TexHandles[BumpMapIndex] = TexInfo[BumpMapIndex].BindlessTexHandle;
+			DrawFlags |= ShaderDrawFlags::DF_BumpMap;
+		}
+		else
+		{
 # if ENGINE_VERSION==1100
-		Surface.Texture->Texture->BumpMap->Lock(Shader->BumpMapInfo, Viewport->CurrentTime, 0, this);
+			BumpMap->Lock(Shader->BumpMapInfo, Viewport->CurrentTime, 0, this);
 # else
-		Surface.Texture->Texture->BumpMap->Lock(Shader->BumpMapInfo, FTime(), 0, this);
+			BumpMap->Lock(Shader->BumpMapInfo, FTime(), 0, this);
 # endif
-#endif
-		SetTextureHelper(this, BumpMapIndex, FTEXTURE_GET(Shader->BumpMapInfo), PF_None, DrawFlags, ShaderDrawFlags::DF_BumpMap, 0.0, nullptr, &DrawCallParams->BumpMapInfo, DrawCallParams->TexHandles);
+			BumpMapLocked = TRUE;
+			SetTextureHelper(this, BumpMapIndex, FTEXTURE_GET(Shader->BumpMapInfo), PF_None, DrawFlags, ShaderDrawFlags::DF_BumpMap, 0.0, nullptr, &Material.BumpMapInfo, Material.TexHandles);
+			AddTextureLookup(BumpMapIndex, BumpMap, FTEXTURE_GET(Shader->BumpMapInfo));
+		}
 	}
+#endif
 
 #if ENGINE_VERSION==227
 	if (Surface.EnvironmentMap && EnvironmentMaps)
-		SetTextureHelper(this, EnvironmentMapIndex, *Surface.EnvironmentMap, PF_None, DrawFlags, ShaderDrawFlags::DF_EnvironmentMap, 0.0, &DrawCallParams->EnviroMapUV, nullptr, DrawCallParams->TexHandles);
+		SetTextureHelper(this, EnvironmentMapIndex, *Surface.EnvironmentMap, PF_None, DrawFlags, ShaderDrawFlags::DF_EnvironmentMap, 0.0, &Material.EnviroMapUV, nullptr, Material.TexHandles, &Resolved[EnvironmentMapIndex]);
 
 	if (Surface.HeightMap && ParallaxVersion != Parallax_Disabled)
-		SetTextureHelper(this, HeightMapIndex, *Surface.HeightMap, PF_None, DrawFlags, ShaderDrawFlags::DF_HeightMap, 0.0, nullptr, &DrawCallParams->HeightMapInfo, DrawCallParams->TexHandles);
+		SetTextureHelper(this, HeightMapIndex, *Surface.HeightMap, PF_None, DrawFlags, ShaderDrawFlags::DF_HeightMap, 0.0, nullptr, &Material.HeightMapInfo, Material.TexHandles, &Resolved[HeightMapIndex]);
 #endif
 
 	// Other draw data
@@ -140,59 +187,90 @@ void UXOpenGLRenderDevice::DrawComplexSurface(FSceneNode* Frame, FSurfaceInfo& S
 	DrawCallParams->YAxis = glm::vec4(Facet.MapCoords.YAxis.X, Facet.MapCoords.YAxis.Y, Facet.MapCoords.YAxis.Z, Facet.MapCoords.YAxis | Facet.MapCoords.Origin);
 	DrawCallParams->ZAxis = glm::vec4(Facet.MapCoords.ZAxis.X, Facet.MapCoords.ZAxis.Y, Facet.MapCoords.ZAxis.Z, 0.0);
 	DrawCallParams->DrawFlags = DrawFlags;
+	DrawCallParams->ClipPlanes = ActiveClipPlanes;
+	DrawCallParams->DistanceFog = ActiveDistanceFog;
 
-	Shader->DrawBuffer.StartDrawCall();
-	auto DrawID = Shader->DrawBuffer.GetDrawID();
+	// Lightmaps and fogmaps are unique to the surface, so their handles live in the drawcall parameters
+	DrawCallParams->LightFogHandles[0] = Material.TexHandles[LightMapIndex];
+	DrawCallParams->LightFogHandles[1] = Material.TexHandles[FogMapIndex];
+	Material.TexHandles[LightMapIndex] = Material.TexHandles[FogMapIndex] = 0;
+	DrawCallParams->MaterialIndex = Shader->AddMaterial(Material);
 
-	INT FacetVertexCount = 0;
-	for (FSavedPoly* Poly = Facet.Polys; Poly; Poly = Poly->Next)
+	if (StaticFacet)
 	{
-		const INT NumPts = Poly->NumPts;
-		if (NumPts < 3) //Skip invalid polygons,if any?
-			continue;
+		// The facet's geometry is resident in the static vertex buffer. We only have to stream the drawcall parameters
+		const TArray<FStaticRange>& Ranges = Shader->StaticFacetRanges;
+		Shader->DrawBuffer.AddStaticDrawCall(Ranges(0).First, Ranges(0).Count);
+		for (INT i = 1; i < Ranges.Num(); ++i)
+			Shader->DrawBuffer.ExtendStaticDrawCall(Ranges(i).First, Ranges(i).Count);
+		Shader->ParametersBuffer.Advance(1);
+	}
+	else
+	{
+		Shader->DrawBuffer.StartDrawCall();
 
-		if (!Shader->VertBuffer.CanBuffer((NumPts - 2) * 3))
+		INT FacetVertexCount = 0;
+		for (FSavedPoly* Poly = Facet.Polys; Poly; Poly = Poly->Next)
 		{
-			Shader->DrawBuffer.EndDrawCall(FacetVertexCount);
-			Shader->ParametersBuffer.Advance(1); // advance so Flush automatically restores the drawcall params of the _current_ drawcall
-			Shader->Flush(true);
-			Shader->DrawBuffer.StartDrawCall();
-			DrawID = Shader->DrawBuffer.GetDrawID();
+			const INT NumPts = Poly->NumPts;
+			if (NumPts < 3) //Skip invalid polygons,if any?
+				continue;
+
+			// With indexed fans, we only write every vertex once
+			const INT NumVerts = UsingIndexedFans ? NumPts : (NumPts - 2) * 3;
 
-			// just in case...
-			if ((NumPts - 2) * 3 >= Shader->VertexBufferSize)
+			if (!Shader->VertBuffer.CanBuffer(NumVerts) || !Shader->DrawBuffer.CanBufferFans(1))
 			{
-				debugf(TEXT("DrawComplexSurface facet too big (facet has %d vertices - need to buffer %d points - Vertex Buffer Size is %d)!"), NumPts, (NumPts-2) * 3, Shader->VertexBufferSize);
-				continue;
+				if (UsingIndexedFans)
+					Shader->DrawBuffer.EndFanDrawCall();
+				else
+					Shader->DrawBuffer.EndDrawCall(FacetVertexCount);
+				Shader->ParametersBuffer.Advance(1); // advance so Flush automatically restores the drawcall params of the _current_ drawcall
+				Shader->Flush(true, Flush_BufferFull);
+				Shader->DrawBuffer.StartDrawCall();
+
+				// just in case...
+				if (NumVerts >= Shader->VertexBufferSize)
+				{
+					debugf(TEXT("DrawComplexSurface facet too big (facet has %d vertices - need to buffer %d points - Vertex Buffer Size is %d)!"), NumPts, NumVerts, Shader->VertexBufferSize);
+					continue;
+				}
+
+				FacetVertexCount = 0;
 			}
 
-			FacetVertexCount = 0;
-		}
+			FTransform** In = &Poly->Pts[0];
+			auto Out = Shader->VertBuffer.GetCurrentElementPtr();
 
-		FTransform** In = &Poly->Pts[0];
-		auto Out = Shader->VertBuffer.GetCurrentElementPtr();
+			if (UsingIndexedFans)
+			{
+				for (INT i = 0; i < NumPts; i++)
+					(Out++)->Coords = FPlaneToVec4(In[i]->Point);
+				Shader->DrawBuffer.AddFan(NumPts);
+			}
+			else
+			{
+				for (INT i = 0; i < NumPts - 2; i++)
+				{
+					(Out++)->Coords = FPlaneToVec4(In[0    ]->Point);
+					(Out++)->Coords = FPlaneToVec4(In[i + 1]->Point);
+					(Out++)->Coords = FPlaneToVec4(In[i + 2]->Point);
+				}
+				FacetVertexCount += NumVerts;
+			}
 
-		for (INT i = 0; i < NumPts - 2; i++)
-		{
-			// stijn: not using the normals currently, but we're keeping them in
-			// because they make our vertex data aligned to a 32 byte boundary
-			(Out  )->Coords = FPlaneToVec4(In[0    ]->Point);
-			(Out++)->DrawID = DrawID;
-			(Out  )->Coords = FPlaneToVec4(In[i + 1]->Point);
-			(Out++)->DrawID = DrawID;
-			(Out  )->Coords = FPlaneToVec4(In[i + 2]->Point);
-			(Out++)->DrawID = DrawID;
+			Shader->VertBuffer.Advance(NumVerts);
 		}
 
-		FacetVertexCount += (NumPts - 2) * 3;
-		Shader->VertBuffer.Advance((NumPts - 2) * 3);
+		if (UsingIndexedFans)
+			Shader->DrawBuffer.EndFanDrawCall();
+		else
+			Shader->DrawBuffer.EndDrawCall(FacetVertexCount);
+		Shader->ParametersBuffer.Advance(1);
 	}
 
-	Shader->DrawBuffer.EndDrawCall(FacetVertexCount);
-	Shader->ParametersBuffer.Advance(1);
-
 #if ENGINE_VERSION!=227
-	if (DrawFlags & ShaderDrawFlags::DF_BumpMap)
+	if (BumpMapLocked)
 		Surface.Texture->Texture->BumpMap->Unlock(Shader->BumpMapInfo);
 #endif
 
@@ -220,6 +298,9 @@ UXOpenGLRenderDevice::DrawComplexProgram::DrawComplexProgram(const TCHAR* Name,
 	DrawMode						= GL_TRIANGLES;
 	UseSSBOParametersBuffer			= RenDev->UsingShaderDrawParameters;
 	ParametersInfo					= DrawComplexParametersInfo;
+	MaterialsInfo					= DrawComplexMaterialInfo;
+	MaterialsBufferSize				= DRAWCOMPLEX_SIZE;
+	MaterialsBufferBindingIndex		= GlobalShaderBindingIndices::ComplexMaterialsIndex;
 	VertexShaderFunc				= &BuildVertexShader;
 	GeoShaderFunc					= nullptr;
 	FragmentShaderFunc				= &BuildFragmentShader;
@@ -233,19 +314,226 @@ UXOpenGLRenderDevice::DrawComplexProgram::DrawComplexProgram(const TCHAR* Name,
 		ShaderCompilationOptions::OPT_DistanceFog |
 		ShaderCompilationOptions::OPT_ClipDistance |
 		ShaderCompilationOptions::OPT_Editor |
-		ShaderCompilationOptions::OPT_SimulateMultiPass;
+		ShaderCompilationOptions::OPT_SimulateMultiPass |
+		ShaderCompilationOptions::OPT_StaticBSPCache;
 }
 
 void UXOpenGLRenderDevice::DrawComplexProgram::CreateInputLayout()
 {
-	for (INT i = 0; i < 3; ++i)
-		glEnableVertexAttribArray(i);
+	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DrawComplexVertex), (GLvoid*)(0));
-	glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT,   sizeof(DrawComplexVertex), (GLvoid*)(offsetof(DrawComplexVertex, DrawID)));
-	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(DrawComplexVertex), (GLvoid*)(offsetof(DrawComplexVertex, Normal)));
+	CreateDrawIDInputLayout();
+	if (RenDev->UsingIndexedFans)
+		CreateFanIndexBuffer(VertexBufferSize);
 	VertBuffer.SetInputLayoutCreated();
 }
 
+void UXOpenGLRenderDevice::DrawComplexProgram::CreateStaticInputLayout()
+{
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (GLvoid*)(0));
+}
+
+void UXOpenGLRenderDevice::DrawComplexProgram::MapBuffers()
+{
+	ShaderProgramImpl::MapBuffers();
+
+	if (!MaterialsBuffer.Buffer)
+	{
+		if (UseSSBOParametersBuffer)
+		{
+			MaterialsBufferSize = Min<INT>(MaterialsBufferSize, (RenDev->MaxSSBOBlockSize / sizeof(DrawComplexMaterial) / (RenDev->UsingPersistentBuffers ? NUMBUFFERS : 1)));
+			MaterialsBuffer.GenerateSSBOBuffer(RenDev, MaterialsBufferBindingIndex);
+			MaterialsBuffer.MapSSBOBuffer(RenDev->UsingPersistentBuffers, MaterialsBufferSize, DRAWCALL_BUFFER_USAGE_PATTERN);
+		}
+		else
+		{
+			MaterialsBufferSize = Min<INT>(MaterialsBufferSize, GetMaximumUniformBufferSize(MaterialsInfo) / (RenDev->UsingPersistentBuffers ? NUMBUFFERS : 1));
+			MaterialsBuffer.GenerateUBOBuffer(RenDev, MaterialsBufferBindingIndex);
+			MaterialsBuffer.MapUBOBuffer(RenDev->UsingPersistentBuffers, MaterialsBufferSize, DRAWCALL_BUFFER_USAGE_PATTERN);
+		}
+		Materials.Empty();
+		MaterialIndices.Empty();
+	}
+
+	if (RenDev->UsingStaticBSPCache)
+		MapStaticBuffers(sizeof(glm::vec3), DRAWCOMPLEX_STATIC_SIZE);
+}
+
+void UXOpenGLRenderDevice::DrawComplexProgram::UnmapBuffers()
+{
+	ShaderProgramImpl::UnmapBuffers();
+	MaterialsBuffer.DeleteBuffer();
+	Materials.Empty();
+	MaterialIndices.Empty();
+}
+
+void UXOpenGLRenderDevice::DrawComplexProgram::EmptyStaticCache()
+{
+	ShaderProgramImpl::EmptyStaticCache();
+	if (StaticNodes.Num())
+		appMemzero(&StaticNodes(0), StaticNodes.Num() * sizeof(FStaticRange));
+}
+
+void UXOpenGLRenderDevice::DrawComplexProgram::BufferMaterials()
+{
+	if (MaterialsBuffer.NextElemIndex > MaterialsBuffer.FirstUnbufferedElemIndex)
+	{
+		MaterialsBuffer.Bind();
+		MaterialsBuffer.BufferData(false);
+	}
+}
+
+void UXOpenGLRenderDevice::DrawComplexProgram::RotateMaterials()
+{
+	// The first slot of the new parameters buffer holds a copy of the last drawcall's parameters.
+	// Its material lives in the buffer we are about to leave, so we have to carry it over
+	DrawComplexParameters* CarriedParams = ParametersBuffer.GetCurrentElementPtr();
+	const INT CarriedIndex = static_cast<INT>(CarriedParams->MaterialIndex) - static_cast<INT>(MaterialsBuffer.SubBufferOffset);
+	const bool HaveCarriedMaterial = CarriedIndex >= 0 && CarriedIndex < Materials.Num();
+	DrawComplexMaterial CarriedMaterial;
+	if (HaveCarriedMaterial)
+		CarriedMaterial = Materials(CarriedIndex);
+
+	MaterialsBuffer.Bind();
+	MaterialsBuffer.Lock();
+	MaterialsBuffer.Rotate(true);
+	Materials.EmptyNoRealloc();
+	MaterialIndices.Empty();
+
+	if (HaveCarriedMaterial)
+		CarriedParams->MaterialIndex = AddMaterial(CarriedMaterial);
+
+	// Rotating the parameters buffer must still find it bound
+	ParametersBuffer.Bind();
+}
+
+glm::uint UXOpenGLRenderDevice::DrawComplexProgram::AddMaterial(const DrawComplexMaterial& Material)
+{
+	QWORD Hash = 14695981039346656037ULL;
+	const DWORD* Data = reinterpret_cast<const DWORD*>(&Material);
+	for (INT i = 0; i < static_cast<INT>(sizeof(DrawComplexMaterial) / sizeof(DWORD)); ++i)
+		HashStaticValue(Hash, Data[i]);
+
+	const INT* Existing = MaterialIndices.Find(Hash);
+	if (Existing && appMemcmp(&Materials(*Existing), &Material, sizeof(DrawComplexMaterial)) == 0)
+		return MaterialsBuffer.SubBufferOffset + *Existing;
+
+	const INT Index = Materials.AddItem(Material);
+	MaterialIndices.Set(Hash, Index);
+	*MaterialsBuffer.GetCurrentElementPtr() = Material;
+	MaterialsBuffer.Advance(1);
+	return MaterialsBuffer.SubBufferOffset + Index;
+}
+
+//
+// Resolves the polys of @Facet into ranges of the static vertex buffer and leaves them in
+// StaticFacetRanges. Render stores the BSP node of every poly in its User field, so we cache
+// node by node and triangulate the node's own vertices from the model. Those are exact and
+// unclipped, which means we never have to look at the points Render transformed for us.
+// Movers are filtered into the BSP every time they move, so we stream their nodes.
+// Returns false if the facet has to be streamed instead.
+//
+bool UXOpenGLRenderDevice::DrawComplexProgram::CacheStaticFacet(FSceneNode* Frame, FSurfaceFacet& Facet)
+{
+	UModel* Model = Frame->Level ? Frame->Level->Model : nullptr;
+	if (!Model || !Model->Nodes.Num())
+		return false;
+
+	// The level BSP only changes when the engine loads a map, and it flushes the device when it does.
+	// The editor modifies the BSP in place, so we don't use this cache there
+	if (Model != StaticModel)
+	{
+		if (NumStaticVertices > 0)
+		{
+			// Pending draw calls may still reference the old contents of the static buffer
+			Flush(false, Flush_BufferFull);
+			EmptyStaticCache();
+		}
+		StaticModel = Model;
+		StaticNodes.Empty(Model->Nodes.Num());
+		StaticNodes.AddZeroed(Model->Nodes.Num());
+	}
+
+	const FBspNode* Nodes = &Model->Nodes(0);
+	const INT NumNodes = Min(Model->Nodes.Num(), StaticNodes.Num());
+	FMovingBrushTrackerBase* BrushTracker = Frame->Level->BrushTracker;
+	for (INT Pass = 0; Pass < 2; ++Pass)
+	{
+		// Figure out which nodes we have to upload, and how much room they need
+		INT NumPolys = 0, NewVerts = 0;
+		for (FSavedPoly* Poly = Facet.Polys; Poly; Poly = Poly->Next)
+		{
+			if (Poly->NumPts < 3)
+				continue;
+
+			const FBspNode* Node = static_cast<const FBspNode*>(Poly->User);
+			if (Node < Nodes || Node >= Nodes + NumNodes || Node->NumVertices < 3)
+				return false;
+
+			// The brush tracker adds mover polys as new nodes and reuses their indices when the mover moves
+			if ((Node->NodeFlags & NF_IsNew) || (BrushTracker && BrushTracker->SurfIsDynamic(Node->iSurf)))
+				return false;
+
+			const FStaticRange& Range = StaticNodes(static_cast<INT>(Node - Nodes));
+			if (!Range.Count)
+				NewVerts += (Node->NumVertices - 2) * 3;
+			NumPolys++;
+		}
+
+		// A facet that does not fit into an empty cache, or that needs more draw commands than a batch can hold, gets streamed
+		if (!NumPolys || NewVerts > StaticVertexBufferSize || NumPolys >= DrawBuffer.ArrayCommands.Num())
+			return false;
+
+		if (NumStaticVertices + NewVerts <= StaticVertexBufferSize)
+			break;
+
+		// Out of space. We haven't written any parameters for this draw call yet, so this is a safe place to start over
+		Flush(false, Flush_BufferFull);
+		EmptyStaticCache();
+	}
+
+	StaticFacetRanges.EmptyNoRealloc();
+	for (FSavedPoly* Poly = Facet.Polys; Poly; Poly = Poly->Next)
+	{
+		if (Poly->NumPts < 3)
+			continue;
+
+		const FBspNode& Node = *static_cast<const FBspNode*>(Poly->User);
+		FStaticRange& Range = StaticNodes(static_cast<INT>(&Node - Nodes));
+		if (!Range.Count)
+		{
+			// Triangulate
+			StaticFacetVerts.EmptyNoRealloc();
+			const FVector& First = Model->Points(Model->Verts(Node.iVertPool).pVertex);
+			for (INT i = 1; i < Node.NumVertices - 1; i++)
+			{
+				const FVector& B = Model->Points(Model->Verts(Node.iVertPool + i).pVertex);
+				const FVector& C = Model->Points(Model->Verts(Node.iVertPool + i + 1).pVertex);
+				StaticFacetVerts.AddItem(glm::vec3(First.X, First.Y, First.Z));
+				StaticFacetVerts.AddItem(glm::vec3(B.X, B.Y, B.Z));
+				StaticFacetVerts.AddItem(glm::vec3(C.X, C.Y, C.Z));
+			}
+			Range.Count = StaticFacetVerts.Num();
+			Range.First = UploadStaticVertices(&StaticFacetVerts(0), Range.Count);
+		}
+
+		// Nodes we uploaded together usually sit next to each other in the static buffer
+		if (StaticFacetRanges.Num())
+		{
+			FStaticRange& Last = StaticFacetRanges(StaticFacetRanges.Num() - 1);
+			if (Last.First + Last.Count == Range.First)
+			{
+				Last.Count += Range.Count;
+				continue;
+			}
+		}
+		StaticFacetRanges.AddItem(Range);
+	}
+
+	return true;
+}
+
 /*-----------------------------------------------------------------------------
 	The End.
 -----------------------------------------------------------------------------*/
@@ -18,9 +18,23 @@
 const UXOpenGLRenderDevice::ShaderProgram::DrawCallParameterInfo UXOpenGLRenderDevice::DrawComplexParametersInfo[]
 =
 {
-	{"vec4", "DiffuseUV", 0},
 	{"vec4", "LightMapUV", 0},
 	{"vec4", "FogMapUV", 0},
+	{"vec4", "XAxis", 0},
+	{"vec4", "YAxis", 0},
+	{"vec4", "ZAxis", 0},
+	{"uvec4", "LightFogHandles", 0},
+	{"uint", "MaterialIndex", 0},
+	{"uint", "DrawFlags", 0},
+	{"uint", "ClipPlanes", 0},
+	{"uint", "DistanceFog", 0},
+	{ nullptr, nullptr, 0}
+};
+
+const UXOpenGLRenderDevice::ShaderProgram::DrawCallParameterInfo UXOpenGLRenderDevice::DrawComplexMaterialInfo[]
+=
+{
+	{"vec4", "DiffuseUV", 0},
 	{"vec4", "DetailUV", 0},
 	{"vec4", "MacroUV", 0},
 	{"vec4", "EnviroMapUV", 0},
@@ -28,15 +42,9 @@ const UXOpenGLRenderDevice::ShaderProgram::DrawCallParameterInfo UXOpenGLRenderD
 	{"vec4", "MacroInfo", 0},
 	{"vec4", "BumpMapInfo", 0},
 	{"vec4", "HeightMapInfo", 0},
-	{"vec4", "XAxis", 0},
-	{"vec4", "YAxis", 0},
-	{"vec4", "ZAxis", 0},
 	{"vec4", "DrawColor", 0},
+	{"vec4", "DiffuseModifier", 2},
     {"uvec4", "TexHandles", 4},
-	{"uint", "DrawFlags", 0},
-    {"uint", "Dummy0", 0},
-    {"uint", "Dummy1", 0},
-    {"uint", "Dummy2", 0},
 	{ nullptr, nullptr, 0}
 };
 
@@ -44,9 +52,12 @@ const UXOpenGLRenderDevice::ShaderProgram::DrawCallParameterInfo UXOpenGLRenderD
 void UXOpenGLRenderDevice::DrawComplexProgram::BuildVertexShader(GLuint ShaderType, UXOpenGLRenderDevice * GL, FShaderWriterX & Out)
 {
     Out << R"(
+#if OPT_StaticBSPCache
+layout(location = 0) in vec3 InCoords; // cached static geometry is stored in world space, streamed geometry in view space
+#else
 layout(location = 0) in vec3 Coords; // == gl_Vertex
-layout(location = 1) in uint DrawID; // emulated gl_DrawID
-layout(location = 2) in vec4 Normal;
+#endif
+layout(location = 1) in uint DrawID; // instanced attribute. The baseInstance of the draw call selects the DrawID
 
 out vec3 vCoords;
 out vec2 vTexCoords;
@@ -85,6 +96,15 @@ out float gl_ClipDistance[OPT_MaxClippingPlanes];
 
 void main(void)
 {
+  uint DrawFlags = GetDrawFlags(DrawID);
+
+#if OPT_StaticBSPCache
+  // World to Viewspace projection
+  vec3 Coords = InCoords;
+  if ((DrawFlags & DF_StaticGeometry) == DF_StaticGeometry)
+    Coords = (InCoords - FrameCoords[0].xyz) * mat3(FrameCoords[1].xyz, FrameCoords[2].xyz, FrameCoords[3].xyz);
+#endif
+
   // Point Coords
   vCoords = Coords.xyz;
 
@@ -95,8 +115,6 @@ void main(void)
   vec3 MapCoordsZAxis = GetZAxis(DrawID).xyz;
 #endif
 
-  uint DrawFlags = GetDrawFlags(DrawID);
-
   float UDot = GetXAxis(DrawID).w;
   float VDot = GetYAxis(DrawID).w;
   
@@ -107,7 +125,10 @@ void main(void)
   // Texture UV to fragment
   vec2 TexMapMult = GetDiffuseUV(DrawID).xy;
   vec2 TexMapPan = GetDiffuseUV(DrawID).zw;
-  vTexCoords = (MapDot - TexMapPan) * TexMapMult;
+  vec2 TexMapDot = MapDot - TexMapPan;
+  if ((DrawFlags & DF_TexModifier) == DF_TexModifier)
+    TexMapDot = vec2(dot(GetDiffuseModifier(DrawID, 0u).xyz, vec3(TexMapDot, 1.0)), dot(GetDiffuseModifier(DrawID, 1u).xyz, vec3(TexMapDot, 1.0)));
+  vTexCoords = TexMapDot * TexMapMult;
 
   // Texture UV Lightmap to fragment
   if ((DrawFlags & DF_LightMap) == DF_LightMap)
@@ -178,8 +199,9 @@ void main(void)
   vDrawID = DrawID;
 
 #if OPT_ClipDistance
-  uint ClipIndex = uint(ClipParams.x);
-  gl_ClipDistance[ClipIndex] = PlaneDot(ClipPlane, Coords.xyz);
+  uint ClipPlaneSet = GetClipPlanes(DrawID);
+  for (uint i = 0u; i < uint(OPT_MaxClippingPlanes); ++i)
+    gl_ClipDistance[i] = ClipDistance(ClipPlaneSet, i, Coords.xyz);
 #endif
 }
 )";
@@ -370,6 +392,11 @@ layout(location = 0, index = 0) out vec4 FragColor;
     Out << R"(
 uvec2 GetTexHandleHelper(uint DrawID, uint Index)
 {
+	// Lightmaps and fogmaps are per-surface. Everything else comes from the material
+	if (Index == LightMapIndex)
+		return GetLightFogHandles(DrawID).xy;
+	if (Index == FogMapIndex)
+		return GetLightFogHandles(DrawID).zw;
 	uvec4 Handles = GetTexHandles(DrawID, Index / 2u);
 	return (Index % 2u == 0u) ? Handles.xy : Handles.zw;
 }
@@ -593,7 +620,8 @@ void main(void)
 
 #if OPT_DistanceFog
   // Add DistanceFog, needs to be added after Light has been applied. 
-  if (DistanceFogMode >= 0)
+  DistanceFogInfo Fog = DistanceFogs[GetDistanceFog(vDrawID)];
+  if (Fog.Mode >= 0)
   {
     vec4 MixColor;
     if ((DrawFlags & DF_Modulated) == DF_Modulated)
@@ -601,10 +629,10 @@ void main(void)
     else if ((DrawFlags & DF_Translucent) == DF_Translucent && (DrawFlags & DF_EnvironmentMap) != DF_EnvironmentMap)
       MixColor = vec4(0.0, 0.0, 0.0, 0.0);
     else
-      MixColor = DistanceFogColor;
+      MixColor = Fog.Color;
 
     float FogCoord = abs(vEyeSpacePos.z / vEyeSpacePos.w);
-    TotalColor = mix(TotalColor, MixColor, getFogFactor(FogCoord));
+    TotalColor = mix(TotalColor, MixColor, getFogFactor(Fog, FogCoord));
   }
 #endif
 	
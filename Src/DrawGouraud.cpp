@@ -12,34 +12,204 @@
         * On a long run this should be replaced with a more mode
           modern mesh rendering method, but this requires also quite some
           rework in Render.dll and will be not compatible with other
-          UEngine1 games.
+          UEngine1 games. Mesh buffering (UseMeshBuffering) can only
+          cache the transformed and lit vertices Render hands us.
 
 	Revision history:
 		* Created by Smirftsch
 		* Added buffering to DrawGouraudPolygon
 		* implemented proper usage of persistent buffers.
 		* Added bindless texture support.
+		* Added mesh buffering.
 
 =============================================================================*/
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/packing.hpp>
 #include "XOpenGLDrv.h"
 #include "XOpenGL.h"
 
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+# include <emmintrin.h>
+# define XOPENGL_SSE2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+# define XOPENGL_NEON 1
+#endif
+
 /*-----------------------------------------------------------------------------
 	Helpers
 -----------------------------------------------------------------------------*/
 
-static void BufferVert(UXOpenGLRenderDevice::DrawGouraudVertex* Vert, FTransTexture* P, glm::uint DrawID)
+// Packs a normal into GL_INT_2_10_10_10_REV. The shaders renormalize so 10 bits per component are plenty
+static inline glm::uint PackNormal(const FVector& N)
+{
+	return glm::packSnorm3x10_1x2(glm::vec4(N.X, N.Y, N.Z, 0.f));
+}
+
+// Packs a color into RGBA16F. Render hands us overbright light and modulation colors, so unlike
+// RGBA8 this must keep values above 1. Negative values still get clamped
+#define MAX_HALF_COLOR 65504.f
+static inline glm::uint64 PackColorHalf(const FPlane& C)
+{
+	return glm::packHalf4x16(glm::clamp(glm::vec4(C.X, C.Y, C.Z, C.W), glm::vec4(0.f), glm::vec4(MAX_HALF_COLOR)));
+}
+
+static void BufferVert(UXOpenGLRenderDevice::DrawGouraudVertex* Vert, FTransTexture* P)
 {
 	Vert->Coords		= glm::vec3(P->Point.X, P->Point.Y, P->Point.Z);
-	Vert->DrawID		= DrawID;
-	Vert->Normals		= glm::vec4(P->Normal.X, P->Normal.Y, P->Normal.Z, 0.f);
+	Vert->Normals		= PackNormal(P->Normal);
 	Vert->TexCoords     = glm::vec2(P->U, P->V);
-	Vert->LightColor	= glm::vec4(P->Light.X, P->Light.Y, P->Light.Z, P->Light.W);
-	Vert->FogColor		= glm::vec4(P->Fog.X, P->Fog.Y, P->Fog.Z, P->Fog.W);
+	Vert->LightColor	= PackColorHalf(P->Light);
+	Vert->FogColor		= PackColorHalf(P->Fog);
+}
+
+#if XOPENGL_SSE2
+//
+// Converts four floats in [0,MAX_HALF_COLOR] into halfs in the low 16 bits of each lane. This rounds
+// to nearest even like glm::packHalf, but flushes values that would become denormals to zero
+//
+static inline __m128i FloatToHalf(__m128 X)
+{
+	const __m128i Bits = _mm_castps_si128(X);
+	const __m128i Odd  = _mm_and_si128(_mm_srli_epi32(Bits, 13), _mm_set1_epi32(1));
+	const __m128i Half = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(Bits, _mm_set1_epi32(0xFFF - ((127 - 15) << 23))), Odd), 13);
+	return _mm_and_si128(Half, _mm_castps_si128(_mm_cmpge_ps(X, _mm_set1_ps(6.10351562e-05f))));
+}
+
+//
+// Assembles one vertex in three registers: Coords.xyz and Normals in @Lo, TexCoords.uv and
+// LightColor in @Mid and FogColor in the upper half of @Colors.
+//
+// Note that the loads from P->Point and P->Normal read one float past the
+// vector. That float belongs to the same FTransTexture and is discarded.
+//
+static inline void TranscodeVert(const FTransTexture* P, __m128i& Lo, __m128i& Mid, __m128i& Colors)
+{
+	const __m128 Zero		= _mm_setzero_ps();
+	const __m128 One		= _mm_set1_ps(1.f);
+	const __m128 MinusOne	= _mm_set1_ps(-1.f);
+	const __m128 MaxColor	= _mm_set1_ps(MAX_HALF_COLOR);
+
+	// Same scale and clamp as glm::packSnorm3x10_1x2 with w = 0. We round halfway cases to even while glm rounds them away from zero
+	const __m128i N = _mm_and_si128(_mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(&P->Normal.X), MinusOne), One), _mm_set1_ps(511.f))), _mm_set1_epi32(0x3FF));
+	const INT Normal = _mm_cvtsi128_si32(N) | (_mm_cvtsi128_si32(_mm_srli_si128(N, 4)) << 10) | (_mm_cvtsi128_si32(_mm_srli_si128(N, 8)) << 20);
+
+	// Light in the lower and Fog in the upper 8 bytes. The halfs fit into signed 16 bits, so the saturating pack leaves them alone
+	const __m128i Light = FloatToHalf(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(&P->Light.X), Zero), MaxColor));
+	const __m128i Fog = FloatToHalf(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(&P->Fog.X), Zero), MaxColor));
+	Colors = _mm_packs_epi32(Light, Fog);
+
+	Lo = _mm_or_si128(_mm_and_si128(_mm_castps_si128(_mm_loadu_ps(&P->Point.X)), _mm_set_epi32(0, -1, -1, -1)), _mm_slli_si128(_mm_cvtsi32_si128(Normal), 12));
+	const __m128i UV = _mm_unpacklo_epi32(_mm_castps_si128(_mm_load_ss(&P->U)), _mm_castps_si128(_mm_load_ss(&P->V)));
+	Mid = _mm_unpacklo_epi64(UV, Colors);
+}
+
+static inline void StoreVert(UXOpenGLRenderDevice::DrawGouraudVertex* Out, const FTransTexture* P)
+{
+	__m128i Lo, Mid, Colors;
+	TranscodeVert(P, Lo, Mid, Colors);
+
+	__m128i* Dest = reinterpret_cast<__m128i*>(Out);
+	_mm_storeu_si128(Dest, Lo);
+	_mm_storeu_si128(Dest + 1, Mid);
+	_mm_storel_epi64(Dest + 2, _mm_unpackhi_epi64(Colors, Colors));
+}
+#endif
+
+//
+// Vectorized BufferVert. Each vertex is assembled in registers and written with
+// full-width stores. The vertex buffer may be write-combined memory, where that
+// is much cheaper than five separate partial writes. With @Stream, the stores
+// bypass the cache altogether. That requires 8 byte aligned output and should
+// only be used on mapped GPU memory, which the CPU never reads back.
+//
+// Vertices are 40 bytes, so only every other vertex starts on a 16 byte boundary.
+// We stream pairs of vertices as five 16 byte blocks.
+//
+static void TranscodeVerts(UXOpenGLRenderDevice::DrawGouraudVertex* Out, const FTransTexture* Pts, INT Count, bool Stream)
+{
+#if XOPENGL_SSE2
+	INT i = 0;
+	if (Stream)
+	{
+		// Our part of the buffer may start in the middle of a pair
+		if (Count > 0 && (reinterpret_cast<PTRINT>(Out) & 15))
+		{
+			StoreVert(Out, Pts);
+			i = 1;
+		}
+
+		for (; i + 1 < Count; i += 2)
+		{
+			__m128i LoA, MidA, ColorsA, LoB, MidB, ColorsB;
+			TranscodeVert(Pts + i, LoA, MidA, ColorsA);
+			TranscodeVert(Pts + i + 1, LoB, MidB, ColorsB);
+
+			__m128i* Dest = reinterpret_cast<__m128i*>(Out + i);
+			_mm_stream_si128(Dest, LoA);
+			_mm_stream_si128(Dest + 1, MidA);
+			_mm_stream_si128(Dest + 2, _mm_unpackhi_epi64(ColorsA, _mm_slli_si128(LoB, 8)));
+			_mm_stream_si128(Dest + 3, _mm_castpd_si128(_mm_shuffle_pd(_mm_castsi128_pd(LoB), _mm_castsi128_pd(MidB), 1)));
+			_mm_stream_si128(Dest + 4, _mm_unpackhi_epi64(MidB, ColorsB));
+		}
+	}
+
+	for (; i < Count; i++)
+		StoreVert(Out + i, Pts + i);
+
+	// Make the streaming stores visible before the buffer gets handed to GL
+	if (Stream)
+		_mm_sfence();
+#elif XOPENGL_NEON
+	const float32x4_t Zero			= vdupq_n_f32(0.f);
+	const float32x4_t One			= vdupq_n_f32(1.f);
+	const float32x4_t MinusOne		= vdupq_n_f32(-1.f);
+	const float32x4_t MaxColor		= vdupq_n_f32(MAX_HALF_COLOR);
+	const int32x4_t   NormalMask	= vdupq_n_s32(0x3FF);
+
+	for (INT i = 0; i < Count; i++)
+	{
+		const FTransTexture* P = Pts + i;
+
+		const int32x4_t N = vandq_s32(vcvtnq_s32_f32(vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(&P->Normal.X), MinusOne), One), 511.f)), NormalMask);
+		const DWORD Normal = vgetq_lane_s32(N, 0) | (vgetq_lane_s32(N, 1) << 10) | (vgetq_lane_s32(N, 2) << 20);
+
+		const float16x4_t Light = vcvt_f16_f32(vminq_f32(vmaxq_f32(vld1q_f32(&P->Light.X), Zero), MaxColor));
+		const float16x4_t Fog = vcvt_f16_f32(vminq_f32(vmaxq_f32(vld1q_f32(&P->Fog.X), Zero), MaxColor));
+
+		const uint32x4_t Lo = vsetq_lane_u32(Normal, vreinterpretq_u32_f32(vld1q_f32(&P->Point.X)), 3);
+		const float32x2_t UV = vset_lane_f32(P->V, vdup_n_f32(P->U), 1);
+		const uint32x4_t Mid = vcombine_u32(vreinterpret_u32_f32(UV), vreinterpret_u32_f16(Light));
+
+		// No non-temporal stores here, but full-width stores still beat the per-field writes
+		uint32_t* Dest = reinterpret_cast<uint32_t*>(Out + i);
+		vst1q_u32(Dest, Lo);
+		vst1q_u32(Dest + 4, Mid);
+		vst1_u32(Dest + 8, vreinterpret_u32_f16(Fog));
+	}
+#else
+	for (INT i = 0; i < Count; i++)
+		BufferVert(Out + i, const_cast<FTransTexture*>(Pts + i));
+#endif
+}
+
+// Poly lists shorter than this are not worth waking up the worker threads for
+#define MIN_PARALLEL_GOURAUD_VERTS 2048
+
+struct FBufferVertsJob
+{
+	UXOpenGLRenderDevice::DrawGouraudVertex* Out;
+	FTransTexture* Pts;
+	bool Stream;
+};
+
+static void BufferVerts(void* Context, INT Begin, INT End)
+{
+	FBufferVertsJob* Job = static_cast<FBufferVertsJob*>(Context);
+	TranscodeVerts(Job->Out + Begin, Job->Pts + Begin, End - Begin, Job->Stream);
 }
 
 static void SetTextureHelper
@@ -51,16 +221,24 @@ static void SetTextureHelper
 	FTEXTURE_PTR& CachedInfo,
 	glm::uint64* TexHandles,
 	DWORD& DrawFlags,
-	DWORD AddDrawFlag
+	DWORD AddDrawFlag,
+	DWORD& LockedFlags
 )
 {
+	// Most polys of a mesh share their detail, macro and bump textures, so we usually resolved this one already
+	if (!RenDev->SetTextureFromLookup(Multi, Texture))
+	{
 #if XOPENGL_MODIFIED_LOCK
-	CachedInfo = Texture->GetTexture(INDEX_NONE, RenDev);
+		CachedInfo = Texture->GetTexture(INDEX_NONE, RenDev);
 #else
-	Texture->Lock(CachedInfo, Frame->Viewport->CurrentTime, -1, RenDev);
+		Texture->Lock(CachedInfo, Frame->Viewport->CurrentTime, -1, RenDev);
+		LockedFlags |= AddDrawFlag;
 #endif
 
-	RenDev->SetTexture(Multi, FTEXTURE_GET(CachedInfo), Texture->PolyFlags, 0.f);
+		RenDev->SetTexture(Multi, FTEXTURE_GET(CachedInfo), Texture->PolyFlags, 0.f);
+		RenDev->AddTextureLookup(Multi, Texture, FTEXTURE_GET(CachedInfo));
+	}
+
 	TexHandles[Multi] = RenDev->TexInfo[Multi].BindlessTexHandle;
 	DrawFlags |= AddDrawFlag;
 }
@@ -75,32 +253,47 @@ DWORD UXOpenGLRenderDevice::PrepareGouraudCall(FSceneNode* Frame, FTextureInfo&
 	UBOOL NoNearZ = (GUglyHackFlags & HACKFLAGS_NoNearZ) == HACKFLAGS_NoNearZ;
 	if (GIsEditor && NextPolyFlags & PF_Selected)
 		DrawFlags |= ShaderDrawFlags::DF_Selected;
+	if (NoNearZ)
+		DrawFlags |= ShaderDrawFlags::DF_NearZ;
+	if (GouraudEnvironmentUVs)
+		DrawFlags |= ShaderDrawFlags::DF_EnvironmentUV;
+	const bool NearZOutdated = NoNearZ && !Frame->Viewport->IsOrtho() &&
+		(StoredFovAngle != Frame->Viewport->Actor->FovAngle ||
+			StoredFX != Frame->FX ||
+			StoredFY != Frame->FY);
 
 	const bool CanBuffer = !Shader->DrawBuffer.IsFull() && Shader->ParametersBuffer.CanBuffer(1);
 
 	// Check if the global state will change
-	if (WillBlendStateChange(CurrentBlendPolyFlags, NextPolyFlags) || // Check if the blending mode will change
-		WillTextureStateChange(0, Info, NextPolyFlags) || // Check if the texture will change
-		StoredbNearZ != NoNearZ ||  // Force a flush if we're switching between NearZ and NoNearZ
-		!CanBuffer // Check if we have room left in the multi-draw array
-	)
+	FResolvedTexture Resolved{};
+	FlushReason Reason = Flush_None;
+	if (!CanBuffer) // Check if we have room left in the multi-draw array
+		Reason = Flush_BufferFull;
+	else if (WillBlendStateChange(CurrentBlendPolyFlags, NextPolyFlags)) // Check if the blending mode will change
+		Reason = Flush_Blend;
+	else if (CheckTexture(DiffuseTextureIndex, Info, NextPolyFlags, Resolved)) // Check if the texture will change
+		Reason = Flush_Texture;
+	else if (NearZOutdated) // The projection has to be rebuilt. Switching between NearZ and NoNearZ is just a draw flag
+		Reason = Flush_NearZ;
+	else if (GouraudCullFace != BatchCullFace) // DrawGouraudTriangles toggles face culling
+		Reason = Flush_Culling;
+
+	if (Reason != Flush_None)
 	{
 		// Dispatch buffered data
-		Shader->Flush(!CanBuffer);
+		Shader->Flush(!CanBuffer, Reason);
 
 		SetBlend(NextPolyFlags);
 
-		if (NoNearZ &&
-			(StoredFovAngle != Frame->Viewport->Actor->FovAngle ||
-				StoredFX != Frame->FX ||
-				StoredFY != Frame->FY ||
-				!StoredbNearZ))
-		{
-			SetProjection(Frame, 1); // TODO/FIXME: Shouldn't this second argument be !NoNearZ ?
-		}
+		if (NearZOutdated)
+			SetProjection(Frame);
+
+		if (GouraudCullFace != BatchCullFace)
+			SetGouraudCulling(GouraudCullFace);
 	}	
 	
-	DrawGouraudParameters* DrawCallParams = Shader->ParametersBuffer.GetCurrentElementPtr();
+	// Build the parameters on the side. The caller decides whether they need a new draw call
+	DrawGouraudParameters* DrawCallParams = &Shader->PendingParams;
 
 	const FLOAT TextureAlpha =
 #if ENGINE_VERSION==227
@@ -111,15 +304,22 @@ DWORD UXOpenGLRenderDevice::PrepareGouraudCall(FSceneNode* Frame, FTextureInfo&
 	
 	DrawCallParams->DrawColor = HitTesting() ? FPlaneToVec4(HitColor) : glm::vec4(0.f, 0.f, 0.f, TextureAlpha);
 
-	SetTexture(DiffuseTextureIndex, Info, NextPolyFlags, 0.0);
+	SetTexture(DiffuseTextureIndex, Info, NextPolyFlags, 0.0, &Resolved);
 	DrawCallParams->DiffuseInfo = glm::vec4(TexInfo[DiffuseTextureIndex].UMult, TexInfo[DiffuseTextureIndex].VMult, Info.Texture ? Info.Texture->Diffuse : 1.f, TextureAlpha);
 	DrawCallParams->TexHandles[DiffuseTextureIndex] = TexInfo[DiffuseTextureIndex].BindlessTexHandle;
 	DrawFlags |= ShaderDrawFlags::DF_DiffuseTexture;
+#if ENGINE_VERSION==227
+	if (GetTexModifier(Info, DrawCallParams->TexModifier))
+		DrawFlags |= ShaderDrawFlags::DF_TexModifier;
+	else
+		DrawCallParams->TexModifier[0] = DrawCallParams->TexModifier[1] = glm::vec4(0.f, 0.f, 0.f, 0.f);
+#endif
 
+	Shader->LockedTextureFlags = 0;
 	DrawCallParams->DetailMacroInfo = glm::vec4(0.f, 0.f, 0.f, 0.f);
 	if (Info.Texture && Info.Texture->DetailTexture && DetailTextures)
 	{
-		SetTextureHelper(this, DetailTextureIndex, Info.Texture->DetailTexture, Frame, Shader->DetailTextureInfo, DrawCallParams->TexHandles, DrawFlags, ShaderDrawFlags::DF_DetailTexture);
+		SetTextureHelper(this, DetailTextureIndex, Info.Texture->DetailTexture, Frame, Shader->DetailTextureInfo, DrawCallParams->TexHandles, DrawFlags, ShaderDrawFlags::DF_DetailTexture, Shader->LockedTextureFlags);
 		DrawCallParams->DetailMacroInfo.x = TexInfo[DetailTextureIndex].UMult;
 		DrawCallParams->DetailMacroInfo.y = TexInfo[DetailTextureIndex].VMult;
 	}
@@ -128,19 +328,21 @@ DWORD UXOpenGLRenderDevice::PrepareGouraudCall(FSceneNode* Frame, FTextureInfo&
 #if ENGINE_VERSION==227
 	if (Info.Texture && Info.Texture->BumpMap && BumpMaps)
 	{
-		SetTextureHelper(this, BumpMapIndex, Info.Texture->BumpMap, Frame, Shader->BumpMapInfo, DrawCallParams->TexHandles, DrawFlags, ShaderDrawFlags::DF_BumpMap);
+		SetTextureHelper(this, BumpMapIndex, Info.Texture->BumpMap, Frame, Shader->BumpMapInfo, DrawCallParams->TexHandles, DrawFlags, ShaderDrawFlags::DF_BumpMap, Shader->LockedTextureFlags);
 		DrawCallParams->MiscInfo.x = Info.Texture->BumpMap->Specular;
 	}
 #endif
 
 	if (Info.Texture && Info.Texture->MacroTexture && MacroTextures)
 	{
-		SetTextureHelper(this, MacroTextureIndex, Info.Texture->MacroTexture, Frame, Shader->MacroTextureInfo, DrawCallParams->TexHandles, DrawFlags, ShaderDrawFlags::DF_MacroTexture);
+		SetTextureHelper(this, MacroTextureIndex, Info.Texture->MacroTexture, Frame, Shader->MacroTextureInfo, DrawCallParams->TexHandles, DrawFlags, ShaderDrawFlags::DF_MacroTexture, Shader->LockedTextureFlags);
 		DrawCallParams->DetailMacroInfo.z = TexInfo[MacroTextureIndex].UMult;
 		DrawCallParams->DetailMacroInfo.w = TexInfo[MacroTextureIndex].VMult;
 	}
 
 	DrawCallParams->DrawFlags = DrawFlags;
+	DrawCallParams->ClipPlanes = ActiveClipPlanes;
+	DrawCallParams->DistanceFog = ActiveDistanceFog;
 	return DrawFlags;
 }
 
@@ -148,14 +350,15 @@ void UXOpenGLRenderDevice::FinishGouraudCall(FTextureInfo& Info, DWORD DrawFlags
 {
 #if !XOPENGL_MODIFIED_LOCK
 	auto Shader = dynamic_cast<DrawGouraudProgram*>(Shaders[Gouraud_Prog]);
-	if (DrawFlags & ShaderDrawFlags::DF_DetailTexture)
+	if (Shader->LockedTextureFlags & ShaderDrawFlags::DF_DetailTexture)
 		Info.Texture->DetailTexture->Unlock(Shader->DetailTextureInfo);
 
-	if (DrawFlags & ShaderDrawFlags::DF_BumpMap)
+	if (Shader->LockedTextureFlags & ShaderDrawFlags::DF_BumpMap)
 		Info.Texture->BumpMap->Unlock(Shader->BumpMapInfo);
 
-	if (DrawFlags & ShaderDrawFlags::DF_MacroTexture)
+	if (Shader->LockedTextureFlags & ShaderDrawFlags::DF_MacroTexture)
 		Info.Texture->MacroTexture->Unlock(Shader->MacroTextureInfo);
+	Shader->LockedTextureFlags = 0;
 #endif
 }
 
@@ -179,20 +382,11 @@ void UXOpenGLRenderDevice::DrawGouraudPolygon(FSceneNode* Frame, FTextureInfo& I
 		return;
 
 	auto InVertexCount = NumPts - 2;
-	auto OutVertexCount = InVertexCount * 3;
-
-#if ENGINE_VERSION==227
-	if (Info.Modifier)
-	{
-		FLOAT UM = Info.USize, VM = Info.VSize;
-		for (INT i = 0; i < NumPts; ++i)
-			Info.Modifier->TransformPointUV(Pts[i]->U, Pts[i]->V, UM, VM);
-	}
-#endif
+	auto OutVertexCount = UsingIndexedFans ? NumPts : InVertexCount * 3;
 
-	if (!Shader->VertBuffer.CanBuffer(OutVertexCount)) // we check the available capacity of the parameters and draw buffer elsewhere
+	if (!Shader->VertBuffer.CanBuffer(OutVertexCount) || !Shader->DrawBuffer.CanBufferFans(1)) // we check the available capacity of the parameters and draw buffer elsewhere
 	{
-		Shader->Flush(true);
+		Shader->Flush(true, Flush_BufferFull);
 
 		// just in case...
 		if (OutVertexCount >= Shader->VertexBufferSize)
@@ -204,21 +398,53 @@ void UXOpenGLRenderDevice::DrawGouraudPolygon(FSceneNode* Frame, FTextureInfo& I
 
 	DWORD DrawFlags = PrepareGouraudCall(Frame, Info, PolyFlags);
 
-	Shader->DrawBuffer.StartDrawCall();
+	// Particles, decals and the like often send many polygons in a row with the same parameters.
+	// Those just extend the previous draw call
+	const bool ExtendDrawCall = Shader->PendingParamsMatchLast() &&
+		(UsingIndexedFans ? Shader->DrawBuffer.CanExtendFanDrawCall() : Shader->DrawBuffer.CanExtendDrawCall());
+	if (!ExtendDrawCall)
+		Shader->WritePendingParams();
+
 	auto Out = Shader->VertBuffer.GetCurrentElementPtr();
-	const auto DrawID = Shader->DrawBuffer.GetDrawID();
 
-	// Unfan and buffer
-	for (INT i = 0; i < InVertexCount; i++)
+	if (UsingIndexedFans)
 	{
-		BufferVert(Out++, Pts[0    ], DrawID);
-		BufferVert(Out++, Pts[i + 1], DrawID);
-		BufferVert(Out++, Pts[i + 2], DrawID);
+		// Buffer every vertex once and draw the polygon as an indexed fan
+		for (INT i = 0; i < NumPts; i++)
+			BufferVert(Out++, Pts[i]);
+
+		if (ExtendDrawCall)
+		{
+			Shader->DrawBuffer.ExtendFanDrawCall(NumPts);
+		}
+		else
+		{
+			Shader->DrawBuffer.AddFan(NumPts);
+			Shader->DrawBuffer.EndFanDrawCall();
+		}
+	}
+	else
+	{
+		if (!ExtendDrawCall)
+			Shader->DrawBuffer.StartDrawCall();
+
+		// Unfan and buffer
+		for (INT i = 0; i < InVertexCount; i++)
+		{
+			BufferVert(Out++, Pts[0    ]);
+			BufferVert(Out++, Pts[i + 1]);
+			BufferVert(Out++, Pts[i + 2]);
+		}
+
+		if (ExtendDrawCall)
+			Shader->DrawBuffer.ExtendDrawCall(OutVertexCount);
+		else
+			Shader->DrawBuffer.EndDrawCall(OutVertexCount);
 	}
 
-	Shader->DrawBuffer.EndDrawCall(OutVertexCount);
 	Shader->VertBuffer.Advance(OutVertexCount);
-	Shader->ParametersBuffer.Advance(1);
+	if (!ExtendDrawCall)
+		Shader->ParametersBuffer.Advance(1);
 
 	FinishGouraudCall(Info, DrawFlags);
     STAT(unclockFast(Stats.GouraudPolyCycles));
@@ -241,50 +467,52 @@ void UXOpenGLRenderDevice::DrawGouraudPolyList(FSceneNode* Frame, FTextureInfo&
 	if (NumPts < 3 /*|| Frame->Recursion > MAX_FRAME_RECURSION*/) //reject invalid.
 		return;
 
-#if ENGINE_VERSION==227
-	if (Info.Modifier)
-	{
-		FLOAT UM = Info.USize, VM = Info.VSize;
-		for (INT i = 0; i < NumPts; ++i)
-			Info.Modifier->TransformPointUV(Pts[i].U, Pts[i].V, UM, VM);
-	}
-#endif
-
 	DWORD DrawFlags = PrepareGouraudCall(Frame, Info, PolyFlags);
 
-	Shader->DrawBuffer.StartDrawCall();
-	auto Out = Shader->VertBuffer.GetCurrentElementPtr();
-	auto End = Shader->VertBuffer.GetLastElementPtr();
-	auto DrawID = Shader->DrawBuffer.GetDrawID();
-
-	INT PolyListSize = 0;
-	for (INT i = 0; i < NumPts; i++)
+	// Static draw calls are dispatched after the streamed ones, so we only buffer meshes whose draw order doesn't matter.
+	// PrepareGouraudCall only built the parameters on the side, so CacheMesh can still flush
+	if (UsingMeshBuffering && !(DrawFlags & (ShaderDrawFlags::DF_Translucent | ShaderDrawFlags::DF_Modulated | ShaderDrawFlags::DF_AlphaBlended)))
 	{
-		// Polylists can be bigger than the vertex buffer so check here if we
-		// need to split the mesh up into separate drawcalls
-		if ((i % 3 == 0) && (Out + 2 > End))
+		const FStaticRange* StaticMesh = Shader->CacheMesh(Frame, Info, Pts, NumPts, PolyFlags);
+		if (StaticMesh)
 		{
-			Shader->DrawBuffer.EndDrawCall(PolyListSize);
-			Shader->VertBuffer.Advance(PolyListSize);
-			Shader->ParametersBuffer.Advance(1); // advance so Flush automatically restores the drawcall params of the _current_ drawcall
-
-			Shader->Flush(true);
-			//debugf(NAME_DevGraphics, TEXT("DrawGouraudPolyList overflow!"));
+			Shader->PendingParams.DrawFlags |= ShaderDrawFlags::DF_StaticGeometry;
+			Shader->WritePendingParams();
+			Shader->DrawBuffer.AddStaticDrawCall(StaticMesh->First, StaticMesh->Count);
+			Shader->ParametersBuffer.Advance(1);
 
-			Shader->DrawBuffer.StartDrawCall();
-			Out = Shader->VertBuffer.GetCurrentElementPtr();
-			End = Shader->VertBuffer.GetLastElementPtr();
-			DrawID = Shader->DrawBuffer.GetDrawID();
-
-			PolyListSize = 0;
+			FinishGouraudCall(Info, DrawFlags);
+			STAT(unclockFast(Stats.GouraudPolyCycles));
+			return;
 		}
-
-		BufferVert(Out++, &Pts[i], DrawID);
-		PolyListSize++;
 	}
 
-	Shader->DrawBuffer.EndDrawCall(PolyListSize);
-	Shader->VertBuffer.Advance(PolyListSize);
+	Shader->WritePendingParams();
+	Shader->DrawBuffer.StartDrawCall();
+	for (INT First = 0; ; )
+	{
+		// Polylists can be bigger than the vertex buffer so split the mesh up
+		// into separate drawcalls of as many whole triangles as will fit
+		const auto Out = Shader->VertBuffer.GetCurrentElementPtr();
+		const INT Room = static_cast<INT>(Shader->VertBuffer.GetLastElementPtr() - Out + 1) / 3 * 3;
+		const INT PolyListSize = Min(NumPts - First, Room);
+
+		// Every vertex gets its own slot, so the workers never touch the same part of the buffer
+		FBufferVertsJob Job{ Out, Pts + First, Shader->VertBuffer.IsPersistent() && !(reinterpret_cast<PTRINT>(Out) & 7) };
+		ParallelFor(PolyListSize, MIN_PARALLEL_GOURAUD_VERTS, BufferVerts, &Job);
+
+		Shader->DrawBuffer.EndDrawCall(PolyListSize);
+		Shader->VertBuffer.Advance(PolyListSize);
+		First += PolyListSize;
+		if (First >= NumPts)
+			break;
+
+		Shader->ParametersBuffer.Advance(1); // advance so Flush automatically restores the drawcall params of the _current_ drawcall
+		Shader->Flush(true, Flush_BufferFull);
+		//debugf(NAME_DevGraphics, TEXT("DrawGouraudPolyList overflow!"));
+
+		Shader->DrawBuffer.StartDrawCall();
+	}
 	Shader->ParametersBuffer.Advance(1);
 
 	FinishGouraudCall(Info, DrawFlags);
@@ -304,63 +532,62 @@ void UXOpenGLRenderDevice::DrawGouraudTriangles(const FSceneNode* Frame, const F
 
     STAT(clockFast(Stats.GouraudPolyCycles));
 
-	INT StartOffset = 0;
-	INT i = 0;
-
 	if (Frame->NearClip.W != 0.0)
 		PushClipPlane(Frame->NearClip);
 
-	for (; i < NumPts; i += 3)
+	// Environment mapping. The vertex shader derives the UVs from the normals we buffer anyway
+	GouraudEnvironmentUVs = (PolyFlags & PF_Environment) != 0;
+
+	if (UsingGPUTriangleRejection)
 	{
-		if (Frame->Mirror == -1.0)
-			Exchange(Pts[i + 2], Pts[i]);
+		// Submit the whole list at once. The clipper throws away outcoded triangles and
+		// GL_CULL_FACE the backfaces. Mirroring flips the winding, so we cull the front faces instead
+		if (!(PolyFlags & PF_TwoSided))
+			GouraudCullFace = Frame->Mirror == -1.0 ? GL_FRONT : GL_BACK;
+		DrawGouraudPolyList(const_cast<FSceneNode*>(Frame), const_cast<FTextureInfo&>(Info), Pts, NumPts, PolyFlags, nullptr);
+		GouraudCullFace = GL_NONE;
+	}
+	else
+	{
+		INT StartOffset = 0;
+		INT i = 0;
 
-		// Environment mapping.
-		if (PolyFlags & PF_Environment)
+		for (; i < NumPts; i += 3)
 		{
-			FLOAT UScale = Info.UScale * Info.USize / 256.0f;
-			FLOAT VScale = Info.VScale * Info.VSize / 256.0f;
+			if (Frame->Mirror == -1.0)
+				Exchange(Pts[i + 2], Pts[i]);
 
-			for (INT j = 0; j < 3; j++)
+			// If outcoded, skip it.
+			if (Pts[i].Flags & Pts[i + 1].Flags & Pts[i + 2].Flags)
 			{
-				FVector T = Pts[i + j].Point.UnsafeNormal().MirrorByVector(Pts[i + j].Normal).TransformVectorBy(Frame->Uncoords);
-				Pts[i + j].U = (T.X + 1.0f) * 0.5f * 256.0f * UScale;
-				Pts[i + j].V = (T.Y + 1.0f) * 0.5f * 256.0f * VScale;
-			}
-		}
-
-		// If outcoded, skip it.
-		if (Pts[i].Flags & Pts[i + 1].Flags & Pts[i + 2].Flags)
-		{
-			// stijn: push the triangles we've already processed (if any)
-			if (i - StartOffset > 0)
-			{
-				DrawGouraudPolyList(const_cast<FSceneNode*>(Frame), const_cast<FTextureInfo&>(Info), Pts + StartOffset, i - StartOffset, PolyFlags, nullptr);
+				// stijn: push the triangles we've already processed (if any)
+				if (i - StartOffset > 0)
+					DrawGouraudPolyList(const_cast<FSceneNode*>(Frame), const_cast<FTextureInfo&>(Info), Pts + StartOffset, i - StartOffset, PolyFlags, nullptr);
 				StartOffset = i + 3;
+				continue;
 			}
-			continue;
-		}
 
-		// Backface reject it.
-		if ((PolyFlags & PF_TwoSided) && FTriple(Pts[i].Point, Pts[i + 1].Point, Pts[i + 2].Point) <= 0.0)
-		{
-			if (!(PolyFlags & PF_TwoSided))
+			// Backface reject it. Two-sided backfaces get flipped around instead
+			if (FTriple(Pts[i].Point, Pts[i + 1].Point, Pts[i + 2].Point) <= 0.0)
 			{
-				// stijn: push the triangles we've already processed (if any)
-				if (i - StartOffset > 0)
+				if (!(PolyFlags & PF_TwoSided))
 				{
-					DrawGouraudPolyList(const_cast<FSceneNode*>(Frame), const_cast<FTextureInfo&>(Info), Pts + StartOffset, i - StartOffset, PolyFlags, nullptr);
+					// stijn: push the triangles we've already processed (if any)
+					if (i - StartOffset > 0)
+						DrawGouraudPolyList(const_cast<FSceneNode*>(Frame), const_cast<FTextureInfo&>(Info), Pts + StartOffset, i - StartOffset, PolyFlags, nullptr);
 					StartOffset = i + 3;
+					continue;
 				}
-				continue;
+				Exchange(Pts[i + 2], Pts[i]);
 			}
-			Exchange(Pts[i + 2], Pts[i]);
 		}
+
+		// stijn: push the remaining triangles
+		if (i - StartOffset > 0)
+			DrawGouraudPolyList(const_cast<FSceneNode*>(Frame), const_cast<FTextureInfo&>(Info), Pts + StartOffset, i - StartOffset, PolyFlags, nullptr);
 	}
 
-	// stijn: push the remaining triangles
-	if (i - StartOffset > 0)
-		DrawGouraudPolyList(const_cast<FSceneNode*>(Frame), const_cast<FTextureInfo&>(Info), Pts + StartOffset, i - StartOffset, PolyFlags, nullptr);
+	GouraudEnvironmentUVs = false;
 
 	if (Frame->NearClip.W != 0.0)
 		PopClipPlane();
@@ -422,16 +649,305 @@ UXOpenGLRenderDevice::DrawGouraudProgram::DrawGouraudProgram(const TCHAR* Name,
 
 void UXOpenGLRenderDevice::DrawGouraudProgram::CreateInputLayout()
 {
-	for (INT i = 0; i < 6; ++i)
-		glEnableVertexAttribArray(i);
+	// The streaming and static vertex buffers share the same layout
+	CreateStaticInputLayout();
+	CreateDrawIDInputLayout();
+	if (RenDev->UsingIndexedFans)
+		CreateFanIndexBuffer(VertexBufferSize);
+	VertBuffer.SetInputLayoutCreated();
+}
+
+void UXOpenGLRenderDevice::DrawGouraudProgram::CreateStaticInputLayout()
+{
 	using Vert = DrawGouraudVertex;
+	for (INT i = 0; i < 6; ++i)
+		if (i != 1)
+			glEnableVertexAttribArray(i);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLvoid*)(0));
-	glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT,   sizeof(Vert), (GLvoid*)(offsetof(Vert, DrawID)));
-	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLvoid*)(offsetof(Vert, Normals)));
+	glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(Vert), (GLvoid*)(offsetof(Vert, Normals)));
 	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLvoid*)(offsetof(Vert, TexCoords)));
-	glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLvoid*)(offsetof(Vert, LightColor)));
-	glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(Vert), (GLvoid*)(offsetof(Vert, FogColor)));
-	VertBuffer.SetInputLayoutCreated();
+	glVertexAttribPointer(4, 4, GL_HALF_FLOAT, GL_FALSE, sizeof(Vert), (GLvoid*)(offsetof(Vert, LightColor)));
+	glVertexAttribPointer(5, 4, GL_HALF_FLOAT, GL_FALSE, sizeof(Vert), (GLvoid*)(offsetof(Vert, FogColor)));
+}
+
+void UXOpenGLRenderDevice::DrawGouraudProgram::MapBuffers()
+{
+	ShaderProgramImpl::MapBuffers();
+
+	if (RenDev->UsingMeshBuffering)
+		MapStaticBuffers(sizeof(DrawGouraudVertex), DRAWGOURAUD_STATIC_SIZE);
+}
+
+void UXOpenGLRenderDevice::DrawGouraudProgram::EmptyStaticCache()
+{
+	ShaderProgramImpl::EmptyStaticCache();
+	MeshBuckets.Empty();
+	MeshMisses.Empty();
+	MeshEntries.EmptyNoRealloc();
+	MeshCopies.EmptyNoRealloc();
+}
+
+void UXOpenGLRenderDevice::DrawGouraudProgram::DeactivateShader()
+{
+	ShaderProgramImpl::DeactivateShader();
+
+	// The other programs don't cull faces
+	if (RenDev->BatchCullFace != GL_NONE)
+		RenDev->SetGouraudCulling(GL_NONE);
+}
+
+//
+// Face culling for UseGPUTriangleRejection. The caller must have flushed the Gouraud draws already
+//
+void UXOpenGLRenderDevice::SetGouraudCulling(GLenum Face)
+{
+	// Deferred draw calls were buffered without culling. We don't defer Gouraud draws while culling
+	FlushDeferredPrograms(Flush_Culling);
+
+	GLState.SetEnabled(GL_CULL_FACE, Face != GL_NONE);
+	if (Face != GL_NONE)
+		GLState.SetCullFace(Face);
+	BatchCullFace = Face;
+}
+
+//
+// Looks up the mesh in the mesh buffer. Render does not tell us which mesh or animation frame it
+// is drawing, so we identify a mesh by its texture, flags and the exact bits of its UVs. Those
+// never change between frames. Instances of the same mesh share this key, so every key holds
+// a chain of entries that remember the world-space vertices they were built from.
+//
+// An entry only matches if the new vertices are within a small tolerance of that copy, which
+// absorbs the rounding errors of the view->world transformation without introducing any
+// rounding boundaries. Meshes are first recorded as candidates and only uploaded when we see
+// them unchanged in a later frame, so animated meshes, and meshes that Render draws twice in
+// one frame (e.g., in mirrors), never make it into the buffer. Keys that keep missing skip the
+// cache for a while, so meshes that never stand still don't pay for the lookups every frame.
+// Entries are never shared between instances. Each one keeps its own copy in the buffer.
+//
+// This may flush, so we must be called before the parameters of the draw call are written.
+//
+const UXOpenGLRenderDevice::FStaticRange* UXOpenGLRenderDevice::DrawGouraudProgram::CacheMesh(FSceneNode* Frame, FTextureInfo& Info, FTransTexture* Pts, INT NumPts, DWORD PolyFlags)
+{
+	if (NumPts > StaticVertexBufferSize)
+		return nullptr;
+
+	QWORD Hash = 14695981039346656037ULL;
+	HashStaticValue(Hash, static_cast<DWORD>(Info.CacheID));
+	HashStaticValue(Hash, static_cast<DWORD>(Info.CacheID >> 32));
+	HashStaticValue(Hash, PolyFlags);
+	HashStaticValue(Hash, NumPts);
+	for (INT i = 0; i < NumPts; i++)
+	{
+		HashStaticValue(Hash, *reinterpret_cast<const DWORD*>(&Pts[i].U));
+		HashStaticValue(Hash, *reinterpret_cast<const DWORD*>(&Pts[i].V));
+	}
+
+	const DWORD CurrentFrame = RenDev->FrameCount;
+	FMeshMisses* Misses = MeshMisses.Find(Hash);
+	if (Misses && Misses->Count >= MESH_MAX_MISSES)
+	{
+		if (CurrentFrame - Misses->Frame < MESH_MISS_BACKOFF)
+			return nullptr;
+
+		// Try again. This takes two frames, since a new candidate only matches in a later frame
+		Misses->Count = MESH_MAX_MISSES - 2;
+	}
+
+	// Move the mesh into world space. We only pack the vertices when we need to compare or upload them
+	StaticMeshPoints.EmptyNoRealloc();
+	StaticMeshPoints.Add(NumPts);
+	for (INT i = 0; i < NumPts; i++)
+		StaticMeshPoints(i) = Pts[i].Point.TransformPointBy(Frame->Uncoords);
+
+	const INT* Head = MeshBuckets.Find(Hash);
+	FMeshEntry* Stale = nullptr;
+	for (INT iEntry = Head ? *Head : INDEX_NONE; iEntry != INDEX_NONE; iEntry = MeshEntries(iEntry).Next)
+	{
+		FMeshEntry& Entry = MeshEntries(iEntry);
+		if (Entry.Range.Count == NumPts && MatchesMeshCopy(Entry, Pts))
+		{
+			if (Misses)
+				Misses->Count = 0;
+
+			if (Entry.Range.First != INDEX_NONE)
+				return &Entry.Range;
+
+			// Seen again, but in the same frame. That could be a mirror
+			if (Entry.Frame == CurrentFrame)
+				return nullptr;
+
+			// Unchanged since an earlier frame. Upload it
+			if (NumStaticVertices + NumPts > StaticVertexBufferSize)
+			{
+				ResetMeshCache();
+				return nullptr;
+			}
+			BuildMeshVerts(Frame, Pts, NumPts);
+			Entry.Range.First = UploadStaticVertices(&StaticMeshVerts(0), NumPts);
+			return &Entry.Range;
+		}
+
+		// Candidates that did not show up again can be recycled. Their mesh is probably animated
+		if (!Stale && Entry.Range.First == INDEX_NONE && Entry.Frame != CurrentFrame && Entry.Range.Count == NumPts)
+			Stale = &Entry;
+	}
+
+	// Missed
+	if (!Misses)
+		Misses = &MeshMisses.Set(Hash, FMeshMisses());
+	Misses->Count++;
+	Misses->Frame = CurrentFrame;
+
+	// New candidate
+	if (!Stale)
+	{
+		if (MeshCopies.Num() + NumPts > DRAWGOURAUD_STATIC_SIZE * 2)
+		{
+			ResetMeshCache();
+			return nullptr;
+		}
+
+		const INT iEntry = MeshEntries.Add();
+		Stale = &MeshEntries(iEntry);
+		Stale->Copy = MeshCopies.Add(NumPts);
+		Stale->Next = Head ? *Head : INDEX_NONE;
+		MeshBuckets.Set(Hash, iEntry);
+	}
+
+	BuildMeshVerts(Frame, Pts, NumPts);
+	appMemcpy(&MeshCopies(Stale->Copy), &StaticMeshVerts(0), NumPts * sizeof(DrawGouraudVertex));
+	Stale->Range.First = INDEX_NONE;
+	Stale->Range.Count = NumPts;
+	Stale->Frame = CurrentFrame;
+	return nullptr;
+}
+
+// Packs the world-space mesh we left in StaticMeshPoints into StaticMeshVerts
+void UXOpenGLRenderDevice::DrawGouraudProgram::BuildMeshVerts(FSceneNode* Frame, FTransTexture* Pts, INT NumPts)
+{
+	StaticMeshVerts.EmptyNoRealloc();
+	StaticMeshVerts.Add(NumPts);
+	for (INT i = 0; i < NumPts; i++)
+	{
+		const FTransTexture& P = Pts[i];
+		const FVector& Point = StaticMeshPoints(i);
+		DrawGouraudVertex& Vert = StaticMeshVerts(i);
+		Vert.Coords		= glm::vec3(Point.X, Point.Y, Point.Z);
+		Vert.Normals	= PackNormal(P.Normal.TransformVectorBy(Frame->Uncoords));
+		Vert.TexCoords	= glm::vec2(P.U, P.V);
+		Vert.LightColor	= PackColorHalf(P.Light);
+		Vert.FogColor	= PackColorHalf(P.Fog);
+	}
+}
+
+// Checks if the mesh in StaticMeshPoints/Pts matches the copy we kept for @Entry
+bool UXOpenGLRenderDevice::DrawGouraudProgram::MatchesMeshCopy(const FMeshEntry& Entry, FTransTexture* Pts)
+{
+	const FLOAT Tolerance = 0.125f;
+	const DrawGouraudVertex* Copy = &MeshCopies(Entry.Copy);
+	for (INT i = 0; i < Entry.Range.Count; i++)
+	{
+		const FVector& Point = StaticMeshPoints(i);
+		if (Abs(Point.X - Copy[i].Coords.x) > Tolerance ||
+			Abs(Point.Y - Copy[i].Coords.y) > Tolerance ||
+			Abs(Point.Z - Copy[i].Coords.z) > Tolerance ||
+			PackColorHalf(Pts[i].Light) != Copy[i].LightColor ||
+			PackColorHalf(Pts[i].Fog) != Copy[i].FogColor)
+			return false;
+	}
+	return true;
+}
+
+// Throws away all cached meshes and candidates. Pending draw calls may still reference the static buffer, so we have to flush first
+void UXOpenGLRenderDevice::DrawGouraudProgram::ResetMeshCache()
+{
+	Flush(false, Flush_BufferFull);
+	EmptyStaticCache();
+}
+
+/*-----------------------------------------------------------------------------
+	Benchmark.
+-----------------------------------------------------------------------------*/
+
+//
+// BENCHGOURAUDVERTS: measures how fast BufferVert and TranscodeVerts fill the
+// Gouraud vertex buffer with a synthetic poly list. Results are in MB of
+// vertex data written per second.
+//
+static DOUBLE TimeVerts(UXOpenGLRenderDevice::DrawGouraudVertex* Out, FTransTexture* Pts, INT Count, INT Mode)
+{
+	const INT Iterations = 64;
+	const FTime StartTime = appSeconds();
+	for (INT Iteration = 0; Iteration < Iterations; Iteration++)
+	{
+		if (Mode == 0)
+		{
+			for (INT i = 0; i < Count; i++)
+				BufferVert(Out + i, Pts + i);
+		}
+		else
+		{
+			TranscodeVerts(Out, Pts, Count, Mode == 2);
+		}
+	}
+	const FLOAT Seconds = appSeconds() - StartTime;
+	return Seconds > 0.0 ? (DOUBLE)Iterations * Count * sizeof(UXOpenGLRenderDevice::DrawGouraudVertex) / (Seconds * 1024.0 * 1024.0) : 0.0;
+}
+
+void UXOpenGLRenderDevice::BenchmarkGouraudVerts(FOutputDevice& Ar)
+{
+	guard(UXOpenGLRenderDevice::BenchmarkGouraudVerts);
+
+	// Exec can run between frames, or while another viewport's context is current
+	MakeCurrent();
+
+	auto Shader = dynamic_cast<DrawGouraudProgram*>(Shaders[Gouraud_Prog]);
+	if (!Shader)
+		return;
+
+	const INT Count = DRAWGOURAUDPOLY_SIZE * 12;
+	TArray<FTransTexture> Pts(Count);
+	for (INT i = 0; i < Count; i++)
+	{
+		FTransTexture& P = Pts(i);
+		P.Point  = FVector(appFrand() * 1024.f, appFrand() * 1024.f, appFrand() * 1024.f);
+		P.Normal = FVector(appFrand() - 0.5f, appFrand() - 0.5f, appFrand() - 0.5f).SafeNormal();
+		P.Light  = FPlane(appFrand(), appFrand(), appFrand(), 1.f);
+		P.Fog    = FPlane(appFrand(), appFrand(), appFrand(), appFrand());
+		P.U      = appFrand() * 256.f;
+		P.V      = appFrand() * 256.f;
+	}
+
+	// Cached system memory first. Keep the array 16 byte aligned for the streaming stores
+	TArray<BYTE> Memory(Count * sizeof(DrawGouraudVertex) + 16);
+	auto Out = reinterpret_cast<DrawGouraudVertex*>((reinterpret_cast<PTRINT>(&Memory(0)) + 15) & ~static_cast<PTRINT>(15));
+	Ar.Logf(TEXT("XOpenGL: Gouraud vertices to system memory: BufferVert %.0f MB/s, TranscodeVerts %.0f MB/s, streaming %.0f MB/s"),
+		TimeVerts(Out, &Pts(0), Count, 0), TimeVerts(Out, &Pts(0), Count, 1), TimeVerts(Out, &Pts(0), Count, 2));
+
+	// Then mapped memory of the same kind DrawGouraudPolyList writes to. We use a scratch buffer, since
+	// the GPU may still read any part of the live vertex buffer
+	if (Shader->VertBuffer.IsPersistent())
+	{
+		constexpr GLbitfield PersistentBufferFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		const GLsizeiptr Size = Count * sizeof(DrawGouraudVertex);
+
+		// Use the copy binding point so we do not disturb the GL_ARRAY_BUFFER binding of the streaming VBO
+		GLuint Scratch = 0;
+		glGenBuffers(1, &Scratch);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, Scratch);
+		glBufferStorage(GL_COPY_WRITE_BUFFER, Size, nullptr, PersistentBufferFlags);
+		Out = static_cast<DrawGouraudVertex*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, Size, PersistentBufferFlags));
+		if (Out)
+		{
+			Ar.Logf(TEXT("XOpenGL: Gouraud vertices to mapped memory: BufferVert %.0f MB/s, TranscodeVerts %.0f MB/s, streaming %.0f MB/s"),
+				TimeVerts(Out, &Pts(0), Count, 0), TimeVerts(Out, &Pts(0), Count, 1), TimeVerts(Out, &Pts(0), Count, 2));
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		glDeleteBuffers(1, &Scratch);
+	}
+
+	unguard;
 }
 
 /*-----------------------------------------------------------------------------
@@ -23,9 +23,10 @@ const UXOpenGLRenderDevice::ShaderProgram::DrawCallParameterInfo UXOpenGLRenderD
     {"vec4", "MiscInfo", 0},
     {"vec4", "DrawColor", 0},
     {"uvec4", "TexHandles", 4},
+    {"vec4", "TexModifier", 2},
     {"uint", "DrawFlags", 0},
-    {"uint", "Dummy0", 0},
-    {"uint", "Dummy1", 0},
+    {"uint", "ClipPlanes", 0},
+    {"uint", "DistanceFog", 0},
     {"uint", "Dummy2", 0},
     { nullptr, nullptr, 0}
 };
@@ -59,10 +60,10 @@ static const char* InterfaceBlockData = R"(
 void UXOpenGLRenderDevice::DrawGouraudProgram::BuildVertexShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out)
 {
     Out << R"(
-layout(location = 0) in vec3 Coords; // == gl_Vertex
-layout(location = 1) in uint DrawID; // emulated gl_DrawID
-layout(location = 2) in vec4 Normals; // Normals
-layout(location = 3) in vec2 TexCoords; // TexCoords
+layout(location = 0) in vec3 InCoords; // == gl_Vertex
+layout(location = 1) in uint DrawID; // instanced attribute. The baseInstance of the draw call selects the DrawID
+layout(location = 2) in vec4 InNormals; // Normals
+layout(location = 3) in vec2 InTexCoords; // TexCoords
 layout(location = 4) in vec4 LightColor;
 layout(location = 5) in vec4 FogColor;
 
@@ -80,6 +81,30 @@ out float gl_ClipDistance[OPT_MaxClippingPlanes];
 void main(void)
 {
   uint DrawFlags = GetDrawFlags(DrawID);
+  vec3 Coords = InCoords;
+  vec4 Normals = InNormals;
+  vec2 TexCoords = InTexCoords;
+
+  // Buffered meshes are stored in world space
+  if ((DrawFlags & DF_StaticGeometry) == DF_StaticGeometry)
+  {
+    mat3 InFrameCoords = mat3(FrameCoords[1].xyz, FrameCoords[2].xyz, FrameCoords[3].xyz); // TransformPointBy...
+    Coords = (InCoords - FrameCoords[0].xyz) * InFrameCoords;
+    Normals = vec4(InNormals.xyz * InFrameCoords, 0.0);
+  }
+
+  // Environment mapping. Reflect the view vector around the normal and map the world space reflection onto the texture
+  if ((DrawFlags & DF_EnvironmentUV) == DF_EnvironmentUV)
+  {
+    mat3 InFrameUncoords = mat3(FrameUncoords[1].xyz, FrameUncoords[2].xyz, FrameUncoords[3].xyz);
+    vec3 T = reflect(normalize(Coords), normalize(Normals.xyz)) * InFrameUncoords;
+    TexCoords = (T.xy + 1.0) * 0.5 / GetDiffuseInfo(DrawID).xy;
+  }
+
+  // Texture modifier. Applied before scaling, so the detail and macro textures follow the diffuse texture
+  if ((DrawFlags & DF_TexModifier) == DF_TexModifier)
+    TexCoords = vec2(dot(GetTexModifier(DrawID, 0u).xyz, vec3(TexCoords, 1.0)), dot(GetTexModifier(DrawID, 1u).xyz, vec3(TexCoords, 1.0)));
+
   Out.TexCoords = TexCoords * GetDiffuseInfo(DrawID).xy;
   Out.Coords = Coords;
   Out.LightColor = LightColor * LightColorIntensity;
@@ -120,14 +145,15 @@ void main(void)
   }
 # endif
 
-  gl_Position = modelviewprojMat * vec4(Coords, 1.0);
+  gl_Position = (((DrawFlags & DF_NearZ) == DF_NearZ) ? modelviewprojMatNearZ : modelviewprojMat) * vec4(Coords, 1.0);
 #endif
 
   vDrawID = DrawID;
 
 #if OPT_ClipDistance && !OPT_GeometryShaders
-  uint ClipIndex = uint(ClipParams.x);
-  gl_ClipDistance[ClipIndex] = PlaneDot(ClipPlane, Out.EyeSpacePos.xyz);
+  uint ClipPlaneSet = GetClipPlanes(DrawID);
+  for (uint i = 0u; i < uint(OPT_MaxClippingPlanes); ++i)
+    gl_ClipDistance[i] = ClipDistance(ClipPlaneSet, i, Out.EyeSpacePos.xyz);
 #endif
 }
 )";
@@ -197,7 +223,7 @@ void main(void)
 #endif
 	
 #if OPT_ClipDistance
-  uint ClipIndex = uint(ClipParams.x);
+  uint ClipPlaneSet = GetClipPlanes(vDrawID[0]);
 #endif
 
   gDrawID = vDrawID[0];
@@ -234,9 +260,10 @@ void main(void)
     Out.MacroTexCoords = In[i].MacroTexCoords;
 #endif
 
-    gl_Position = modelviewprojMat * gl_in[i].gl_Position;
+    gl_Position = (((DrawFlags & DF_NearZ) == DF_NearZ) ? modelviewprojMatNearZ : modelviewprojMat) * gl_in[i].gl_Position;
 #if OPT_ClipDistance
-    gl_ClipDistance[ClipIndex] = PlaneDot(ClipPlane, In[i].Coords);
+    for (uint j = 0u; j < uint(OPT_MaxClippingPlanes); ++j)
+      gl_ClipDistance[j] = ClipDistance(ClipPlaneSet, j, In[i].Coords);
 #endif
     EmitVertex();
   }  
@@ -458,7 +485,8 @@ void main(void)
 
 #if OPT_DistanceFog
   // Add DistanceFog, needs to be added after Light has been applied. 
-  if (DistanceFogMode >= 0)
+  DistanceFogInfo Fog = DistanceFogs[GetDistanceFog(DrawID)];
+  if (Fog.Mode >= 0)
   {
     vec4 MixColor;
     if ((DrawFlags & DF_Modulated) == DF_Modulated)
@@ -466,10 +494,10 @@ void main(void)
     else if ((DrawFlags & DF_Translucent) == DF_Translucent && (DrawFlags & DF_EnvironmentMap) != DF_EnvironmentMap)
       MixColor = vec4(0.0, 0.0, 0.0, 0.0);
     else
-      MixColor = DistanceFogColor;
+      MixColor = Fog.Color;
 
     float FogCoord = abs(In.EyeSpacePos.z / In.EyeSpacePos.w);
-    TotalColor = mix(TotalColor, MixColor, getFogFactor(FogCoord));
+    TotalColor = mix(TotalColor, MixColor, getFogFactor(Fog, FogCoord));
   }
 #endif
 
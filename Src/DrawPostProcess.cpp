@@ -68,7 +68,7 @@ UXOpenGLRenderDevice::PostProcessProgram::PostProcessProgram(const TCHAR* Name,
 }
 
 void UXOpenGLRenderDevice::PostProcessProgram::CreateInputLayout() {}
-void UXOpenGLRenderDevice::PostProcessProgram::Flush(bool Rotate)  {}
+void UXOpenGLRenderDevice::PostProcessProgram::Flush(bool Rotate, FlushReason Reason)  {}
 
 void UXOpenGLRenderDevice::PostProcessProgram::MapBuffers()
 {
@@ -84,8 +84,8 @@ void UXOpenGLRenderDevice::PostProcessProgram::ActivateShader()
 {
 	if (RenDev->ArrayPoint)
 		RenDev->ArrayPoint->Unbind();
-	glDisable(GL_CULL_FACE);
-	glDisable(GL_DEPTH_TEST);
+	RenDev->GLState.SetEnabled(GL_CULL_FACE, false);
+	RenDev->GLState.SetEnabled(GL_DEPTH_TEST, false);
 	glBindVertexArray(BlitVAO);
 	UseShader();
 }
@@ -93,7 +93,7 @@ void UXOpenGLRenderDevice::PostProcessProgram::ActivateShader()
 void UXOpenGLRenderDevice::PostProcessProgram::DeactivateShader()
 {
 	glBindVertexArray(0);
-	glEnable(GL_DEPTH_TEST);
+	RenDev->GLState.SetEnabled(GL_DEPTH_TEST, true);
 	// Make sure we set the correct blend state again when we activate the next shader
 	RenDev->CurrentBlendPolyFlags = 0;
 	RenDev->SetNoTexture(DiffuseTextureIndex);
@@ -103,12 +103,11 @@ void UXOpenGLRenderDevice::PostProcessProgram::Draw(GLuint Texture, INT DstW, IN
 {
 	// Direct src-only copy — no dst contribution, without touching GL_BLEND
 	// enabled state (the renderer keeps it always enabled).
-	glBlendFunc(GL_ONE, GL_ZERO);
-	glActiveTexture(GL_TEXTURE0 + DiffuseTextureIndex);
+	RenDev->GLState.SetBlendFunc(GL_ONE, GL_ZERO);
 
 	// Unbind the current sampler for TMU 0 because it might use the wrong filters
-	glBindSampler(DiffuseTextureIndex, 0);
-	glBindTexture(GL_TEXTURE_2D, Texture);
+	RenDev->GLState.BindSampler(DiffuseTextureIndex, 0);
+	RenDev->GLState.BindTexture(DiffuseTextureIndex, Texture);
 	glViewport(0, 0, DstW, DstH);
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 	//glBindTexture(GL_TEXTURE_2D, 0);
@@ -16,13 +16,10 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/packing.hpp>
 #include "XOpenGLDrv.h"
 #include "XOpenGL.h"
 
-/*-----------------------------------------------------------------------------
-	Helpers
------------------------------------------------------------------------------*/
-
 void UXOpenGLRenderDevice::PrepareSimpleCall
 (
 	ShaderProgram* Shader,
@@ -34,7 +31,7 @@ void UXOpenGLRenderDevice::PrepareSimpleCall
 {
 	if (OldLineFlags != LineFlags || OldBlendMode != BlendMode)
 	{
-		Shader->Flush(false);
+		Shader->Flush(false, Flush_Blend);
 
 		OldLineFlags = LineFlags;
 		OldBlendMode = BlendMode;
@@ -62,28 +59,24 @@ void UXOpenGLRenderDevice::Draw2DLine(FSceneNode* Frame, FPlane Color, DWORD Lin
 	auto Shader = dynamic_cast<DrawSimpleLineProgram*>(Shaders[Simple_Line_Prog]);
 	
 	Color.W = 1.f; //Unfortunately this is usually set to 0.
-	const auto DrawColor = HitTesting() ? FPlaneToVec4(HitColor) : FPlaneToVec4(Color);
+	const glm::uint DrawColor = PackColor(HitTesting() ? HitColor : Color);
 	constexpr auto BlendMode = PF_AlphaBlend;
 
 	if (Shader->DrawBuffer.IsFull() || !Shader->ParametersBuffer.CanBuffer(1) || !Shader->VertBuffer.CanBuffer(2))
-		Shader->Flush(true);
+		Shader->Flush(true, Flush_BufferFull);
 
 	PrepareSimpleCall(Shader,
 		Shader->OldLineFlags, LineFlags,
 		Shader->OldBlendMode, BlendMode);
 
-	Shader->ParametersBuffer.GetCurrentElementPtr()->DrawColor = DrawColor;
+	DrawSimpleParameters DrawCallParams{};
+	DrawCallParams.ClipPlanes = ActiveClipPlanes;
 
-	Shader->DrawBuffer.StartDrawCall();
-	auto Out = Shader->VertBuffer.GetCurrentElementPtr();
-	const auto DrawID = Shader->DrawBuffer.GetDrawID();
-	(Out  )->Coords = glm::vec3(RFX2 * P1.Z * (P1.X - Frame->FX2), RFY2 * P1.Z * (P1.Y - Frame->FY2), P1.Z);
-	(Out++)->DrawID = DrawID;
-	(Out  )->Coords = glm::vec3(RFX2 * P2.Z * (P2.X - Frame->FX2), RFY2 * P2.Z * (P2.Y - Frame->FY2), P2.Z);
-	(Out  )->DrawID = DrawID;
-	Shader->VertBuffer.Advance(2);
-	Shader->DrawBuffer.EndDrawCall(2);
-	Shader->ParametersBuffer.Advance(1);
+	auto Out = Shader->BeginPrimitive(DrawCallParams);
+	Out[0].Coords = glm::vec3(RFX2 * P1.Z * (P1.X - Frame->FX2), RFY2 * P1.Z * (P1.Y - Frame->FY2), P1.Z);
+	Out[1].Coords = glm::vec3(RFX2 * P2.Z * (P2.X - Frame->FX2), RFY2 * P2.Z * (P2.Y - Frame->FY2), P2.Z);
+	Out[0].Color = Out[1].Color = DrawColor;
+	Shader->EndPrimitive(2);
 
     STAT(unclockFast(Stats.Draw2DLine));
 	unguard;
@@ -97,10 +90,7 @@ void UXOpenGLRenderDevice::Draw3DLine( FSceneNode* Frame, FPlane Color, DWORD Li
 		return;
 
     STAT(clockFast(Stats.Draw3DLine));
-	SetProgram(Simple_Line_Prog);
 
-	auto Shader = dynamic_cast<DrawSimpleLineProgram*>(Shaders[Simple_Line_Prog]);
-	
 	Color.W = 1.f; //Unfortunately this is usually set to 0.
 
 	P1 = P1.TransformPointBy(Frame->Coords);
@@ -123,28 +113,28 @@ void UXOpenGLRenderDevice::Draw3DLine( FSceneNode* Frame, FPlane Color, DWORD Li
 	}
 	else
 	{
-		const auto DrawColor = HitTesting() ? FPlaneToVec4(HitColor) : FPlaneToVec4(Color);
+		SetProgram(Simple_Line_Prog);
+
+		auto Shader = dynamic_cast<DrawSimpleLineProgram*>(Shaders[Simple_Line_Prog]);
+
+		const glm::uint DrawColor = PackColor(HitTesting() ? HitColor : Color);
 		constexpr auto BlendMode = PF_AlphaBlend;
 
 		if (Shader->DrawBuffer.IsFull() || !Shader->ParametersBuffer.CanBuffer(1) || !Shader->VertBuffer.CanBuffer(2))
-			Shader->Flush(true);
+			Shader->Flush(true, Flush_BufferFull);
 
 		PrepareSimpleCall(Shader,
 			Shader->OldLineFlags, LineFlags,
 			Shader->OldBlendMode, BlendMode);
 
-		Shader->ParametersBuffer.GetCurrentElementPtr()->DrawColor = DrawColor;
-
-		Shader->DrawBuffer.StartDrawCall();
-		auto Out = Shader->VertBuffer.GetCurrentElementPtr();
-		const auto DrawID = Shader->DrawBuffer.GetDrawID();
-		(Out  )->Coords = glm::vec3(P1.X, P1.Y, P1.Z);
-		(Out++)->DrawID = DrawID;
-		(Out  )->Coords = glm::vec3(P2.X, P2.Y, P2.Z);
-		(Out  )->DrawID = DrawID;
-		Shader->VertBuffer.Advance(2);
-		Shader->DrawBuffer.EndDrawCall(2);
-		Shader->ParametersBuffer.Advance(1);
+		DrawSimpleParameters DrawCallParams{};
+		DrawCallParams.ClipPlanes = ActiveClipPlanes;
+
+		auto Out = Shader->BeginPrimitive(DrawCallParams);
+		Out[0].Coords = glm::vec3(P1.X, P1.Y, P1.Z);
+		Out[1].Coords = glm::vec3(P2.X, P2.Y, P2.Z);
+		Out[0].Color = Out[1].Color = DrawColor;
+		Shader->EndPrimitive(2);
 	}
 
     STAT(unclockFast(Stats.Draw3DLine));
@@ -159,12 +149,19 @@ void UXOpenGLRenderDevice::Draw2DPoint( FSceneNode* Frame, FPlane Color, DWORD L
 		return;
 
     STAT(clockFast(Stats.Draw2DPoint));
-	SetProgram(Simple_Triangle_Prog);
 
-	auto Shader = dynamic_cast<DrawSimpleTriangleProgram*>(Shaders[Simple_Triangle_Prog]);
+	// Square points (i.e., almost all of them) are drawn as GL_POINTS. Anything else becomes a quad
+	const FLOAT PointSize = X2 - X1 + 1.f;
+	const bool DrawAsPoint = Abs(PointSize - (Y2 - Y1 + 1.f)) < 0.01f && PointSize >= 1.f &&
+		PointSize <= dynamic_cast<DrawSimplePointProgram*>(Shaders[Simple_Point_Prog])->MaxPointSize;
+	const INT NumVerts = DrawAsPoint ? 1 : 6;
+
+	SetProgram(DrawAsPoint ? Simple_Point_Prog : Simple_Triangle_Prog);
+
+	auto Shader = dynamic_cast<DrawSimpleProgram*>(Shaders[ActiveProgram]);
 	
 	Color.W = 1.f; //Unfortunately this is usually set to 0.
-	const auto DrawColor = HitTesting() ? FPlaneToVec4(HitColor) : FPlaneToVec4(Color);
+	const glm::uint DrawColor = PackColor(HitTesting() ? HitColor : Color);
 	constexpr auto BlendMode = PF_AlphaBlend;
 
 	if (Frame->Viewport->IsOrtho())
@@ -172,33 +169,36 @@ void UXOpenGLRenderDevice::Draw2DPoint( FSceneNode* Frame, FPlane Color, DWORD L
 	else if (Z < 0.f)
 		Z = -Z;
 
-	if (Shader->DrawBuffer.IsFull() || !Shader->ParametersBuffer.CanBuffer(1) || !Shader->VertBuffer.CanBuffer(6))
-		Shader->Flush(true);
+	if (Shader->DrawBuffer.IsFull() || !Shader->ParametersBuffer.CanBuffer(1) || !Shader->VertBuffer.CanBuffer(NumVerts))
+		Shader->Flush(true, Flush_BufferFull);
 
 	PrepareSimpleCall(Shader,
 		Shader->OldLineFlags, LineFlags,
 		Shader->OldBlendMode, BlendMode);
 
-	Shader->ParametersBuffer.GetCurrentElementPtr()->DrawColor = DrawColor;
-
-	Shader->DrawBuffer.StartDrawCall();
-	auto Out = Shader->VertBuffer.GetCurrentElementPtr();
-	const auto DrawID = Shader->DrawBuffer.GetDrawID();
-	(Out  )->Coords = glm::vec3(RFX2 * Z * (X1 - Frame->FX2 - 0.5f), RFY2 * Z * (Y1 - Frame->FY2 - 0.5f), Z);
-	(Out++)->DrawID = DrawID;
-	(Out  )->Coords = glm::vec3(RFX2 * Z * (X2 - Frame->FX2 + 0.5f), RFY2 * Z * (Y1 - Frame->FY2 - 0.5f), Z);
-	(Out++)->DrawID = DrawID;
-	(Out  )->Coords = glm::vec3(RFX2 * Z * (X2 - Frame->FX2 + 0.5f), RFY2 * Z * (Y2 - Frame->FY2 + 0.5f), Z);
-	(Out++)->DrawID = DrawID;
-	(Out  )->Coords = glm::vec3(RFX2 * Z * (X1 - Frame->FX2 - 0.5f), RFY2 * Z * (Y1 - Frame->FY2 - 0.5f), Z);
-	(Out++)->DrawID = DrawID;
-	(Out  )->Coords = glm::vec3(RFX2 * Z * (X2 - Frame->FX2 + 0.5f), RFY2 * Z * (Y2 - Frame->FY2 + 0.5f), Z);
-	(Out++)->DrawID = DrawID;
-	(Out  )->Coords = glm::vec3(RFX2 * Z * (X1 - Frame->FX2 - 0.5f), RFY2 * Z * (Y2 - Frame->FY2 + 0.5f), Z);
-	(Out  )->DrawID = DrawID;
-	Shader->VertBuffer.Advance(6);
-	Shader->DrawBuffer.EndDrawCall(6);
-	Shader->ParametersBuffer.Advance(1);
+	DrawSimpleParameters DrawCallParams{};
+	DrawCallParams.ClipPlanes = ActiveClipPlanes;
+	if (DrawAsPoint)
+		DrawCallParams.PointSize = PointSize;
+
+	auto Out = Shader->BeginPrimitive(DrawCallParams);
+	if (DrawAsPoint)
+	{
+		// GL_POINTS cover the same pixels as the quad below
+		Out[0].Coords = glm::vec3(RFX2 * Z * ((X1 + X2) * 0.5f - Frame->FX2), RFY2 * Z * ((Y1 + Y2) * 0.5f - Frame->FY2), Z);
+	}
+	else
+	{
+		Out[0].Coords = glm::vec3(RFX2 * Z * (X1 - Frame->FX2 - 0.5f), RFY2 * Z * (Y1 - Frame->FY2 - 0.5f), Z);
+		Out[1].Coords = glm::vec3(RFX2 * Z * (X2 - Frame->FX2 + 0.5f), RFY2 * Z * (Y1 - Frame->FY2 - 0.5f), Z);
+		Out[2].Coords = glm::vec3(RFX2 * Z * (X2 - Frame->FX2 + 0.5f), RFY2 * Z * (Y2 - Frame->FY2 + 0.5f), Z);
+		Out[3].Coords = glm::vec3(RFX2 * Z * (X1 - Frame->FX2 - 0.5f), RFY2 * Z * (Y1 - Frame->FY2 - 0.5f), Z);
+		Out[4].Coords = glm::vec3(RFX2 * Z * (X2 - Frame->FX2 + 0.5f), RFY2 * Z * (Y2 - Frame->FY2 + 0.5f), Z);
+		Out[5].Coords = glm::vec3(RFX2 * Z * (X1 - Frame->FX2 - 0.5f), RFY2 * Z * (Y2 - Frame->FY2 + 0.5f), Z);
+	}
+	for (INT i = 0; i < NumVerts; ++i)
+		Out[i].Color = DrawColor;
+	Shader->EndPrimitive(NumVerts);
 
     STAT(unclockFast(Stats.Draw2DPoint));
 	unguard;
@@ -217,84 +217,73 @@ void UXOpenGLRenderDevice::EndFlash()
 	
 	if (FlashScale != FPlane(0.5, 0.5, 0.5, 0) || FlashFog != FPlane(0, 0, 0, 0))
 	{
-		const auto DrawColor = glm::vec4(FlashFog.X, FlashFog.Y, FlashFog.Z, 1.0f - Min(FlashScale.X * 2.f, 1.f));
+		const glm::uint DrawColor = PackColor(FPlane(FlashFog.X, FlashFog.Y, FlashFog.Z, 1.0f - Min(FlashScale.X * 2.f, 1.f)));
 		constexpr auto BlendMode = PF_Highlighted;
 		constexpr DWORD LineFlags = LINE_Transparent;
 
 		if (Shader->DrawBuffer.IsFull() || !Shader->ParametersBuffer.CanBuffer(1) || !Shader->VertBuffer.CanBuffer(6))
-			Shader->Flush(true);
+			Shader->Flush(true, Flush_BufferFull);
 
 		PrepareSimpleCall(Shader,
 			Shader->OldLineFlags, LineFlags,
 			Shader->OldBlendMode, BlendMode);
 
-		Shader->ParametersBuffer.GetCurrentElementPtr()->DrawColor = DrawColor;
+		DrawSimpleParameters DrawCallParams{};
+		DrawCallParams.ClipPlanes = ActiveClipPlanes;
 
 		const FLOAT RFX2 = 2.f * RProjZ / Viewport->SizeX;
 		const FLOAT RFY2 = 2.f * RProjZ * Aspect / Viewport->SizeY;
 
-		Shader->DrawBuffer.StartDrawCall();
-		auto Out = Shader->VertBuffer.GetCurrentElementPtr();
-		const auto DrawID = Shader->DrawBuffer.GetDrawID();
-		(Out  )->Coords = glm::vec3(RFX2 * (-Viewport->SizeX / 2.0), RFY2 * (-Viewport->SizeY / 2.0), 1.f);
-		(Out++)->DrawID = DrawID;
-		(Out  )->Coords = glm::vec3(RFX2 * (+Viewport->SizeX / 2.0), RFY2 * (-Viewport->SizeY / 2.0), 1.f);
-		(Out++)->DrawID = DrawID;
-		(Out  )->Coords = glm::vec3(RFX2 * (+Viewport->SizeX / 2.0), RFY2 * (+Viewport->SizeY / 2.0), 1.f);
-		(Out++)->DrawID = DrawID;
-		(Out  )->Coords = glm::vec3(RFX2 * (-Viewport->SizeX / 2.0), RFY2 * (-Viewport->SizeY / 2.0), 1.f);
-		(Out++)->DrawID = DrawID;
-		(Out  )->Coords = glm::vec3(RFX2 * (+Viewport->SizeX / 2.0), RFY2 * (+Viewport->SizeY / 2.0), 1.f);
-		(Out++)->DrawID = DrawID;
-		(Out  )->Coords = glm::vec3(RFX2 * (-Viewport->SizeX / 2.0), RFY2 * (+Viewport->SizeY / 2.0), 1.f);
-		(Out  )->DrawID = DrawID;
-		Shader->VertBuffer.Advance(6);
-		Shader->DrawBuffer.EndDrawCall(6);
-		Shader->ParametersBuffer.Advance(1);
+		auto Out = Shader->BeginPrimitive(DrawCallParams);
+		Out[0].Coords = glm::vec3(RFX2 * (-Viewport->SizeX / 2.0), RFY2 * (-Viewport->SizeY / 2.0), 1.f);
+		Out[1].Coords = glm::vec3(RFX2 * (+Viewport->SizeX / 2.0), RFY2 * (-Viewport->SizeY / 2.0), 1.f);
+		Out[2].Coords = glm::vec3(RFX2 * (+Viewport->SizeX / 2.0), RFY2 * (+Viewport->SizeY / 2.0), 1.f);
+		Out[3].Coords = glm::vec3(RFX2 * (-Viewport->SizeX / 2.0), RFY2 * (-Viewport->SizeY / 2.0), 1.f);
+		Out[4].Coords = glm::vec3(RFX2 * (+Viewport->SizeX / 2.0), RFY2 * (+Viewport->SizeY / 2.0), 1.f);
+		Out[5].Coords = glm::vec3(RFX2 * (-Viewport->SizeX / 2.0), RFY2 * (+Viewport->SizeY / 2.0), 1.f);
+		for (INT i = 0; i < 6; ++i)
+			Out[i].Color = DrawColor;
+		Shader->EndPrimitive(6);
 	}
 	unguard;
 }
 
 /*-----------------------------------------------------------------------------
-	Simple Line Shader
+	Simple Shaders
 -----------------------------------------------------------------------------*/
 
-UXOpenGLRenderDevice::DrawSimpleLineProgram::DrawSimpleLineProgram(const TCHAR* Name, UXOpenGLRenderDevice* RenDev)
+UXOpenGLRenderDevice::DrawSimpleProgram::DrawSimpleProgram(const TCHAR* Name, UXOpenGLRenderDevice* RenDev)
 	: ShaderProgramImpl(Name, RenDev)
 {
-	VertexBufferSize				= DRAWSIMPLE_SIZE * 2; // 2 vertices per draw call
 	ParametersBufferSize			= DRAWSIMPLE_SIZE;
-	ParametersBufferBindingIndex	= GlobalShaderBindingIndices::SimpleLineParametersIndex;
 	NumTextureSamplers				= 0;
-	DrawMode						= GL_LINES;
 	UseSSBOParametersBuffer			= false;
 	ParametersInfo					= DrawSimpleParametersInfo;
-	VertexShaderFunc				= &BuildVertexShader;
 	GeoShaderFunc					= nullptr;
-	FragmentShaderFunc				= &BuildFragmentShader;
 	RelevantSpecializationOptions =
 		ShaderCompilationOptions::OPT_ClipDistance |
 		ShaderCompilationOptions::OPT_Editor |
 		ShaderCompilationOptions::OPT_SimulateMultiPass;
 }
 
-void UXOpenGLRenderDevice::DrawSimpleLineProgram::CreateInputLayout()
+void UXOpenGLRenderDevice::DrawSimpleProgram::CreateInputLayout()
 {
-	for (INT i = 0; i < 2; ++i)
-		glEnableVertexAttribArray(i);
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(2);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DrawSimpleVertex), (GLvoid*)(0));
-	glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(DrawSimpleVertex), (GLvoid*)(offsetof(DrawSimpleVertex, DrawID)));
+	glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(DrawSimpleVertex), (GLvoid*)(offsetof(DrawSimpleVertex, Color)));
+	CreateDrawIDInputLayout();
 	VertBuffer.SetInputLayoutCreated();
 }
 
-void UXOpenGLRenderDevice::DrawSimpleLineProgram::ActivateShader()
+void UXOpenGLRenderDevice::DrawSimpleProgram::ActivateShader()
 {
 	ShaderProgramImpl::ActivateShader();
 	OldLineFlags = RenDev->CurrentLineFlags;
 	OldBlendMode = RenDev->CurrentBlendPolyFlags;
 }
 
-void UXOpenGLRenderDevice::DrawSimpleLineProgram::DeactivateShader()
+void UXOpenGLRenderDevice::DrawSimpleProgram::DeactivateShader()
 {
 	ShaderProgramImpl::DeactivateShader();
 	if (RenDev->CurrentLineFlags != OldLineFlags)
@@ -303,52 +292,80 @@ void UXOpenGLRenderDevice::DrawSimpleLineProgram::DeactivateShader()
 		RenDev->SetBlend(OldBlendMode);
 }
 
+//
+// Wireframe views consist of thousands of lines that only differ in color. As long as the
+// parameters stay the same, we append the vertices to the previous draw call
+//
+UXOpenGLRenderDevice::DrawSimpleVertex* UXOpenGLRenderDevice::DrawSimpleProgram::BeginPrimitive(const DrawSimpleParameters& Params)
+{
+	ExtendingDrawCall = DrawBuffer.CanExtendDrawCall() && appMemcmp(&Params, &LastParams, sizeof(DrawSimpleParameters)) == 0;
+	if (!ExtendingDrawCall)
+	{
+		memcpy(ParametersBuffer.GetCurrentElementPtr(), &Params, sizeof(DrawSimpleParameters));
+		LastParams = Params;
+		DrawBuffer.StartDrawCall();
+	}
+	return VertBuffer.GetCurrentElementPtr();
+}
+
+void UXOpenGLRenderDevice::DrawSimpleProgram::EndPrimitive(INT NumVerts)
+{
+	VertBuffer.Advance(NumVerts);
+	if (ExtendingDrawCall)
+	{
+		DrawBuffer.ExtendDrawCall(NumVerts);
+	}
+	else
+	{
+		DrawBuffer.EndDrawCall(NumVerts);
+		ParametersBuffer.Advance(1);
+	}
+}
+
+/*-----------------------------------------------------------------------------
+	Simple Line Shader
+-----------------------------------------------------------------------------*/
+
+UXOpenGLRenderDevice::DrawSimpleLineProgram::DrawSimpleLineProgram(const TCHAR* Name, UXOpenGLRenderDevice* RenDev)
+	: DrawSimpleProgram(Name, RenDev)
+{
+	VertexBufferSize				= DRAWSIMPLE_SIZE * 16; // lines share draw calls, so we need far more vertices than parameters
+	ParametersBufferBindingIndex	= GlobalShaderBindingIndices::SimpleLineParametersIndex;
+	DrawMode						= GL_LINES;
+	VertexShaderFunc				= &BuildVertexShader;
+	FragmentShaderFunc				= &BuildFragmentShader;
+}
+
 /*-----------------------------------------------------------------------------
 	Simple Triangle Shader
 -----------------------------------------------------------------------------*/
 
 UXOpenGLRenderDevice::DrawSimpleTriangleProgram::DrawSimpleTriangleProgram(const TCHAR* Name, UXOpenGLRenderDevice* RenDev)
-	: ShaderProgramImpl(Name, RenDev)
+	: DrawSimpleProgram(Name, RenDev)
 {
-	VertexBufferSize				= DRAWSIMPLE_SIZE * 6; // 6 vertices per draw call
-	ParametersBufferSize			= DRAWSIMPLE_SIZE;
+	VertexBufferSize				= DRAWSIMPLE_SIZE * 6; // 6 vertices per quad
 	ParametersBufferBindingIndex	= GlobalShaderBindingIndices::SimpleTriangleParametersIndex;
-	NumTextureSamplers				= 0;
 	DrawMode						= GL_TRIANGLES;
-	UseSSBOParametersBuffer			= false;
-	ParametersInfo					= DrawSimpleParametersInfo;
 	VertexShaderFunc				= &BuildVertexShader;
-	GeoShaderFunc					= nullptr;
 	FragmentShaderFunc				= &BuildFragmentShader;
-	RelevantSpecializationOptions =
-		ShaderCompilationOptions::OPT_ClipDistance |
-		ShaderCompilationOptions::OPT_Editor |
-		ShaderCompilationOptions::OPT_SimulateMultiPass;
 }
 
-void UXOpenGLRenderDevice::DrawSimpleTriangleProgram::CreateInputLayout()
-{
-	for (INT i = 0; i < 2; ++i)
-		glEnableVertexAttribArray(i);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DrawSimpleVertex), (GLvoid*)(0));
-	glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(DrawSimpleVertex), (GLvoid*)(offsetof(DrawSimpleVertex, DrawID)));
-	VertBuffer.SetInputLayoutCreated();
-}
+/*-----------------------------------------------------------------------------
+	Simple Point Shader
+-----------------------------------------------------------------------------*/
 
-void UXOpenGLRenderDevice::DrawSimpleTriangleProgram::ActivateShader()
+UXOpenGLRenderDevice::DrawSimplePointProgram::DrawSimplePointProgram(const TCHAR* Name, UXOpenGLRenderDevice* RenDev)
+	: DrawSimpleProgram(Name, RenDev)
 {
-	ShaderProgramImpl::ActivateShader();
-	OldLineFlags = RenDev->CurrentLineFlags;
-	OldBlendMode = RenDev->CurrentBlendPolyFlags;
-}
+	VertexBufferSize				= DRAWSIMPLE_SIZE * 8; // 1 vertex per point
+	ParametersBufferBindingIndex	= GlobalShaderBindingIndices::SimplePointParametersIndex;
+	DrawMode						= GL_POINTS;
+	VertexShaderFunc				= &BuildVertexShader;
+	FragmentShaderFunc				= &BuildFragmentShader;
 
-void UXOpenGLRenderDevice::DrawSimpleTriangleProgram::DeactivateShader()
-{
-	ShaderProgramImpl::DeactivateShader();
-	if (RenDev->CurrentLineFlags != OldLineFlags)
-		RenDev->SetDepth(OldLineFlags);
-	if (RenDev->CurrentBlendPolyFlags != OldBlendMode)
-		RenDev->SetBlend(OldBlendMode);
+	GLfloat PointSizeRange[2] = { 1.f, 1.f };
+	glGetFloatv(GL_ALIASED_POINT_SIZE_RANGE, PointSizeRange);
+	MaxPointSize = PointSizeRange[1];
 }
 
 /*-----------------------------------------------------------------------------
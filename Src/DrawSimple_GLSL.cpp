@@ -18,7 +18,10 @@
 const UXOpenGLRenderDevice::ShaderProgram::DrawCallParameterInfo UXOpenGLRenderDevice::DrawSimpleParametersInfo[]
 =
 {
-	{"vec4", "DrawColor", 0},
+	{"uint", "ClipPlanes", 0},
+	{"float", "PointSize", 0},
+	{"uint", "Dummy0", 0},
+	{"uint", "Dummy1", 0},
 	{ nullptr, nullptr, 0}
 };
 
@@ -28,7 +31,9 @@ const UXOpenGLRenderDevice::ShaderProgram::DrawCallParameterInfo UXOpenGLRenderD
 
 static const char* SimpleVertexShader = R"(
 layout(location = 0) in vec3 Coords; // == gl_Vertex
-layout(location = 1) in uint DrawID; // emulated gl_DrawID
+layout(location = 1) in uint DrawID; // instanced attribute. The baseInstance of the draw call selects the DrawID
+layout(location = 2) in vec4 Color;
+out vec4 vColor;
 #if OPT_ClipDistance
 out float gl_ClipDistance[OPT_MaxClippingPlanes];
 #endif
@@ -36,10 +41,16 @@ out float gl_ClipDistance[OPT_MaxClippingPlanes];
 void main(void)
 {
   gl_Position = modelviewprojMat * vec4(Coords, 1.0);
+  vColor = Color;
+
+#ifdef DRAW_POINTS
+  gl_PointSize = GetPointSize(DrawID);
+#endif
 
 #if OPT_ClipDistance
-  uint ClipIndex = uint(ClipParams.x);
-  gl_ClipDistance[ClipIndex] = PlaneDot(ClipPlane, Coords);
+  uint ClipPlaneSet = GetClipPlanes(DrawID);
+  for (uint i = 0u; i < uint(OPT_MaxClippingPlanes); ++i)
+    gl_ClipDistance[i] = ClipDistance(ClipPlaneSet, i, Coords);
 #endif
 
   vDrawID = DrawID;
@@ -58,10 +69,11 @@ layout(location = 0, index = 1) out vec4 FragColor1;
 # endif
 layout(location = 0, index = 0) out vec4 FragColor;
 #endif
+in vec4 vColor;
 
 void main(void)
 {
-  vec4 TotalColor = GetDrawColor(vDrawID);
+  vec4 TotalColor = vColor;
 
   // stijn: this is an attempt at stippled line drawing in GL4
 #if 0 && OPT_Transparent
@@ -100,6 +112,21 @@ void UXOpenGLRenderDevice::DrawSimpleTriangleProgram::BuildVertexShader(GLuint S
 }
 
 void UXOpenGLRenderDevice::DrawSimpleTriangleProgram::BuildFragmentShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out)
+{
+	Out << SimpleFragmentShader;
+}
+
+/*-----------------------------------------------------------------------------
+	Simple Point Shader
+-----------------------------------------------------------------------------*/
+
+void UXOpenGLRenderDevice::DrawSimplePointProgram::BuildVertexShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out)
+{
+	Out << "#define DRAW_POINTS 1" END_LINE;
+	Out << SimpleVertexShader;
+}
+
+void UXOpenGLRenderDevice::DrawSimplePointProgram::BuildFragmentShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out)
 {
 	Out << SimpleFragmentShader;
 }
\ No newline at end of file
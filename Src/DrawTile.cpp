@@ -9,6 +9,7 @@
         * Added support for bindless textures
         * removed some blending changes (PF_TwoSided PF_Unlit)
         * Added batching
+        * Tiles are now instances of a vertex-less quad
 =============================================================================*/
 
 #include <glm/glm.hpp>
@@ -29,8 +30,7 @@ void UXOpenGLRenderDevice::DrawTile(FSceneNode* Frame, FTextureInfo& Info, FLOAT
     STAT(clockFast(Stats.TileBufferCycles));
 	SetProgram(Tile_Prog);
 
-	auto ShaderCore = dynamic_cast<DrawTileCoreProgram*>(Shaders[Tile_Prog]);
-	auto ShaderES   = dynamic_cast<DrawTileESProgram*>  (Shaders[Tile_Prog]);
+	auto Shader = static_cast<DrawTileProgram*>(Shaders[Tile_Prog]);
 	
 	DWORD DrawFlags = ShaderDrawFlags::DF_None;
 	DWORD NextPolyFlags = GetPolyFlagsAndDrawFlags(PolyFlags, DrawFlags, TRUE);
@@ -43,7 +43,7 @@ void UXOpenGLRenderDevice::DrawTile(FSceneNode* Frame, FTextureInfo& Info, FLOAT
 	// Hack to render HUD on top of everything in 469
 #if UNREAL_TOURNAMENT_OLDUNREAL
 	BOOL ShouldDepthTest = ((GUglyHackFlags & HACKFLAGS_PostRender) == 0) || Abs(1.f - Z) > SMALL_NUMBER;
-	BOOL& DepthTesting = ShaderCore ? ShaderCore->DepthTesting : ShaderES->DepthTesting;
+	BOOL& DepthTesting = Shader->DepthTesting;
 #endif
 
 	// Color
@@ -64,46 +64,33 @@ void UXOpenGLRenderDevice::DrawTile(FSceneNode* Frame, FTextureInfo& Info, FLOAT
 #endif
 
 	glm::vec4 DrawColor = HitTesting() ? FPlaneToVec4(HitColor) : FPlaneToVec4(Color);
-	bool CanBuffer = false;
-	DrawTileParameters* DrawCallParams = nullptr;
 
-	if (ShaderCore)
-	{
-		CanBuffer = ShaderCore->VertBuffer.CanBuffer(3) && 
-			ShaderCore->ParametersBuffer.CanBuffer(1) &&
-			!ShaderCore->DrawBuffer.IsFull();
-		DrawCallParams = ShaderCore->ParametersBuffer.GetCurrentElementPtr();
-	}
-	else
-	{
-		CanBuffer = ShaderES->VertBuffer.CanBuffer(6) &&
-			ShaderES->ParametersBuffer.CanBuffer(1) &&
-			!ShaderES->DrawBuffer.IsFull();
-		DrawCallParams = ShaderES->ParametersBuffer.GetCurrentElementPtr();
-	}	
+	// Small static textures come from the tile atlas. Switching between them does not break the batch
+	FTileAtlasEntry* AtlasEntry = UsingTileAtlas ? GetTileAtlasEntry(Info, PolyFlags, U, V, UL, VL) : nullptr;
+
+	bool CanBuffer = Shader->ParametersBuffer.CanBuffer(1) && !Shader->DrawBuffer.IsFull();
+	DrawTileParameters* DrawCallParams = Shader->ParametersBuffer.GetCurrentElementPtr();
 
+	// Check if we have space to batch more data
+	FlushReason Reason = Flush_None;
+	if (!CanBuffer)
+		Reason = Flush_BufferFull;
 	// Check if global GL state will change
-	if (WillBlendStateChange(CurrentBlendPolyFlags, PolyFlags) || 
-		// Check if bound sampler state will change
-		WillTextureStateChange(0, Info, NextPolyFlags) ||
-		// Check if we have space to batch more data
-		!CanBuffer
+	else if (WillBlendStateChange(CurrentBlendPolyFlags, PolyFlags))
+		Reason = Flush_Blend;
+	// Check if bound sampler state will change
+	else if (AtlasEntry ? WillTileAtlasStateChange(AtlasEntry, PolyFlags) : WillTextureStateChange(0, Info, NextPolyFlags))
+		Reason = Flush_Texture;
 #if UNREAL_TOURNAMENT_OLDUNREAL
-		// Check if the depth testing mode will change
-		|| ShouldDepthTest != DepthTesting
+	// Check if the depth testing mode will change
+	else if (ShouldDepthTest != DepthTesting)
+		Reason = Flush_DepthTest;
 #endif
-		)
+
+	if (Reason != Flush_None)
 	{
-		if (ShaderCore)
-		{
-			ShaderCore->Flush(!CanBuffer);
-			DrawCallParams = ShaderCore->ParametersBuffer.GetCurrentElementPtr();
-		}
-		else
-		{
-			ShaderES->Flush(!CanBuffer);
-			DrawCallParams = ShaderES->ParametersBuffer.GetCurrentElementPtr();
-		}
+		Shader->Flush(!CanBuffer, Reason);
+		DrawCallParams = Shader->ParametersBuffer.GetCurrentElementPtr();
 
 		// Set new GL state
 		SetBlend(PolyFlags); // yes, we use the original polyflags here!
@@ -111,23 +98,17 @@ void UXOpenGLRenderDevice::DrawTile(FSceneNode* Frame, FTextureInfo& Info, FLOAT
 #if UNREAL_TOURNAMENT_OLDUNREAL
 		if (DepthTesting != ShouldDepthTest)
 		{
-			if (ShouldDepthTest)
-				glEnable(GL_DEPTH_TEST);
-			else
-				glDisable(GL_DEPTH_TEST);
+			GLState.SetEnabled(GL_DEPTH_TEST, ShouldDepthTest ? true : false);
 			DepthTesting = ShouldDepthTest;
 		}
 #endif
 	}
 
 	// Bind texture or fetch its bindless handle
-	SetTexture(DiffuseTextureIndex, Info, PolyFlags, 0);	
-
-	// Buffer new drawcall parameters
-	const auto& TexInfo = this->TexInfo[DiffuseTextureIndex];
-	DrawCallParams->DrawColor = DrawColor;
-	DrawCallParams->TexHandles[DiffuseTextureIndex] = TexInfo.BindlessTexHandle;
-	DrawCallParams->DrawFlags = DrawFlags;
+	if (AtlasEntry)
+		SetTileAtlasTexture(AtlasEntry, Info, PolyFlags);
+	else
+		SetTexture(DiffuseTextureIndex, Info, PolyFlags, 0);
 
 	if (GIsEditor &&
 		Frame->Viewport->Actor &&
@@ -136,158 +117,51 @@ void UXOpenGLRenderDevice::DrawTile(FSceneNode* Frame, FTextureInfo& Info, FLOAT
 		Z = 1.0f; // Probably just needed because projection done below assumes non ortho projection.
 	}
 
-	// Buffer the tile
-	if (ShaderES)
-	{
-		ShaderES->DrawBuffer.StartDrawCall();
-		// ES doesn't have geo shaders so we manually emit two triangles here
-		auto Out = ShaderES->VertBuffer.GetCurrentElementPtr();
-		const auto DrawID = ShaderES->DrawBuffer.GetDrawID();
-
-		// Vertex 0
-		Out[0].Coords = glm::vec3(RFX2 * Z * (X - Frame->FX2), RFY2 * Z * (Y - Frame->FY2), Z);
-		Out[0].DrawID = DrawID;
-		Out[0].TexCoords = glm::vec2((U)*TexInfo.UMult, (V)*TexInfo.VMult);
-
-		// Vertex 1
-		Out[1].Coords = glm::vec3(RFX2 * Z * (X + XL - Frame->FX2), RFY2 * Z * (Y - Frame->FY2), Z);
-		Out[1].DrawID = DrawID;
-		Out[1].TexCoords = glm::vec2((U + UL) * TexInfo.UMult, (V)*TexInfo.VMult);
-
-		// Vertex 2
-		Out[2].Coords = glm::vec3(RFX2 * Z * (X + XL - Frame->FX2), RFY2 * Z * (Y + YL - Frame->FY2), Z);
-		Out[2].DrawID = DrawID;
-		Out[2].TexCoords = glm::vec2((U + UL) * TexInfo.UMult, (V + VL) * TexInfo.VMult);
-
-		// Vertex 0
-		Out[3].Coords = glm::vec3(RFX2 * Z * (X - Frame->FX2), RFY2 * Z * (Y - Frame->FY2), Z);
-		Out[3].DrawID = DrawID;
-		Out[3].TexCoords = glm::vec2((U)*TexInfo.UMult, (V)*TexInfo.VMult);
-
-		// Vertex 2
-		Out[4].Coords = glm::vec3(RFX2 * Z * (X + XL - Frame->FX2), RFY2 * Z * (Y + YL - Frame->FY2), Z);
-		Out[4].DrawID = DrawID;
-		Out[4].TexCoords = glm::vec2((U + UL) * TexInfo.UMult, (V + VL) * TexInfo.VMult);
-
-		// Vertex 3
-		Out[5].Coords = glm::vec3(RFX2 * Z * (X - Frame->FX2), RFY2 * Z * (Y + YL - Frame->FY2), Z);
-		Out[5].DrawID = DrawID;
-		Out[5].TexCoords = glm::vec2((U)*TexInfo.UMult, (V + VL) * TexInfo.VMult);
+	// Buffer new drawcall parameters. The vertex shader expands these into the corners of the tile
+	const auto& TexInfo = this->TexInfo[DiffuseTextureIndex];
+	DrawCallParams->DrawColor = DrawColor;
+	DrawCallParams->TexHandles[DiffuseTextureIndex] = TexInfo.BindlessTexHandle;
+	DrawCallParams->TileCoords = glm::vec4(RFX2 * Z * (X - Frame->FX2), RFY2 * Z * (Y - Frame->FY2), RFX2 * Z * XL, RFY2 * Z * YL);
+	DrawCallParams->TileZ = Z;
+	DrawCallParams->DrawFlags = DrawFlags;
+	DrawCallParams->ClipPlanes = ActiveClipPlanes;
 
-#if ENGINE_VERSION==227
-		if (Info.Modifier)
-		{
-			for (INT i = 0; i < 6; ++i)
-				Info.Modifier->TransformPoint(Out[i].TexCoords.x, Out[i].TexCoords.y);
-		}
-#endif
+	// UV of the top left corner and the UV steps across and down the tile
+	const FLOAT UOffset = AtlasEntry ? AtlasEntry->X / static_cast<FLOAT>(TILE_ATLAS_PAGE_SIZE) : 0.f;
+	const FLOAT VOffset = AtlasEntry ? AtlasEntry->Y / static_cast<FLOAT>(TILE_ATLAS_PAGE_SIZE) : 0.f;
+	FLOAT U0 = UOffset + U * TexInfo.UMult, V0 = VOffset + V * TexInfo.VMult;
+	FLOAT U1 = UOffset + (U + UL) * TexInfo.UMult, V1 = V0;
+	FLOAT U2 = U0, V2 = VOffset + (V + VL) * TexInfo.VMult;
 
-		ShaderES->VertBuffer.Advance(6);
-		ShaderES->DrawBuffer.EndDrawCall(6);
-		ShaderES->ParametersBuffer.Advance(1);
-	}
-	else
+#if ENGINE_VERSION==227
+	if (Info.Modifier)
 	{
-		ShaderCore->DrawBuffer.StartDrawCall();
-		// Our Core geo shader emits the triangles. We only need to pass the tile origin and dimensions
-		auto Out = ShaderCore->VertBuffer.GetCurrentElementPtr();
-		const auto DrawID = ShaderCore->DrawBuffer.GetDrawID();
-
-		Out->Coords = glm::vec3(X, Y, Z);
-		Out->TexCoords0 = glm::vec4(RFX2, RFY2, Frame->FX2, Frame->FY2);
-		Out->TexCoords1 = glm::vec4(U, V, UL, VL);
-		Out->TexCoords2 = glm::vec4(XL, YL, TexInfo.UMult, TexInfo.VMult);
-		(Out++)->DrawID = DrawID;
-		(Out++)->DrawID = DrawID;
-		Out->DrawID = DrawID;
-
-#if ENGINE_VERSION==227 && 0 // TODO - Need to push 2x3 matrix transformation to UV mapping.
-		if (Info.Modifier)
-		{
-		}
-#endif
-
-		ShaderCore->VertBuffer.Advance(3);
-		ShaderCore->DrawBuffer.EndDrawCall(3);
-		ShaderCore->ParametersBuffer.Advance(1);
-	}	
-
-	STAT(unclockFast(Stats.TileBufferCycles));
-}
-
-/*-----------------------------------------------------------------------------
-	OpenGL ES Tile Shader
------------------------------------------------------------------------------*/
-
-UXOpenGLRenderDevice::DrawTileESProgram::DrawTileESProgram(const TCHAR* Name, UXOpenGLRenderDevice* RenDev)
-	: ShaderProgramImpl(Name, RenDev)
-{
-	VertexBufferSize				= DRAWTILE_SIZE * 6; // 6 vertices per draw call
-	ParametersBufferSize			= DRAWTILE_SIZE;
-	ParametersBufferBindingIndex	= GlobalShaderBindingIndices::TileParametersIndex;
-	NumTextureSamplers				= 1;
-	DrawMode						= GL_TRIANGLES;
-	UseSSBOParametersBuffer			= RenDev->UsingShaderDrawParameters; // heh. You never know...
-	ParametersInfo					= DrawTileParametersInfo;
-	VertexShaderFunc				= &BuildVertexShader;
-	GeoShaderFunc					= nullptr;
-	FragmentShaderFunc				= &BuildFragmentShader;
-	DepthTesting					= FALSE;
-}
-
-void UXOpenGLRenderDevice::DrawTileESProgram::CreateInputLayout()
-{
-	for (INT i = 0; i < 3; ++i)
-		glEnableVertexAttribArray(i);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DrawTileVertexES), (GLvoid*)(0));
-	glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(DrawTileVertexES), (GLvoid*)(offsetof(DrawTileVertexES, DrawID)));
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(DrawTileVertexES), (GLvoid*)(offsetof(DrawTileVertexES, TexCoords)));
-	VertBuffer.SetInputLayoutCreated();
-}
-
-void UXOpenGLRenderDevice::DrawTileESProgram::DeactivateShader()
-{
-	ShaderProgramImpl::DeactivateShader();
-
-#if UNREAL_TOURNAMENT_OLDUNREAL
-	if (!DepthTesting)
-		glEnable(GL_DEPTH_TEST);
+		// The modifier is an affine 2x3 transform, so transforming three corners gives
+		// us the exact mapping for the whole tile
+		Info.Modifier->TransformPoint(U0, V0);
+		Info.Modifier->TransformPoint(U1, V1);
+		Info.Modifier->TransformPoint(U2, V2);
+	}
 #endif
 
-	if (RenDev->UseAA && RenDev->NoAATiles)
-		glEnable(GL_MULTISAMPLE);
-}
+	DrawCallParams->TileTexCoords = glm::vec4(U0, V0, U1 - U0, V1 - V0);
+	DrawCallParams->TileTexCoordsY = glm::vec2(U2 - U0, V2 - V0);
 
-void UXOpenGLRenderDevice::DrawTileESProgram::ActivateShader()
-{
-	ShaderProgramImpl::ActivateShader();
-
-#if !defined(__EMSCRIPTEN__) && !__LINUX_ARM__
-	if (RenDev->UseAA && RenDev->NoAATiles)
-		glDisable(GL_MULTISAMPLE);
-#endif
+	Shader->DrawBuffer.AddInstance(6);
+	Shader->ParametersBuffer.Advance(1);
 
-#if UNREAL_TOURNAMENT_OLDUNREAL
-	if (GUglyHackFlags & HACKFLAGS_PostRender) // ugly hack to make the HUD always render on top of weapons
-	{
-		DepthTesting = FALSE;
-		glDisable(GL_DEPTH_TEST);
-	}
-	else
-	{
-		DepthTesting = TRUE;
-	}
-#endif
+	STAT(unclockFast(Stats.TileBufferCycles));
 }
 
 /*-----------------------------------------------------------------------------
-	OpenGL Core Tile Shader
+	Tile Shader
 -----------------------------------------------------------------------------*/
 
-UXOpenGLRenderDevice::DrawTileCoreProgram::DrawTileCoreProgram(const TCHAR* Name, UXOpenGLRenderDevice* RenDev)
+UXOpenGLRenderDevice::DrawTileProgram::DrawTileProgram(const TCHAR* Name, UXOpenGLRenderDevice* RenDev)
 	: ShaderProgramImpl(Name, RenDev)
 {
-	VertexBufferSize				= DRAWTILE_SIZE * 3;
+	VertexBufferSize				= 1; // We only need the VAO. The tile corners come from gl_VertexID
+	VertexlessDraws					= true;
 	ParametersBufferSize			= DRAWTILE_SIZE;
 	ParametersBufferBindingIndex	= GlobalShaderBindingIndices::TileParametersIndex;
 	NumTextureSamplers				= 1;
@@ -295,55 +169,48 @@ UXOpenGLRenderDevice::DrawTileCoreProgram::DrawTileCoreProgram(const TCHAR* Name
 	UseSSBOParametersBuffer			= RenDev->UsingShaderDrawParameters;
 	ParametersInfo					= DrawTileParametersInfo;
 	VertexShaderFunc				= &BuildVertexShader;
-	GeoShaderFunc					= &BuildGeometryShader;
+	GeoShaderFunc					= nullptr;
 	FragmentShaderFunc				= &BuildFragmentShader;
 	DepthTesting					= FALSE;
 	RelevantSpecializationOptions =
 		ShaderCompilationOptions::OPT_ClipDistance |
 		ShaderCompilationOptions::OPT_Editor |
-		ShaderCompilationOptions::OPT_SimulateMultiPass |
-		ShaderCompilationOptions::OPT_GeometryShaders;
+		ShaderCompilationOptions::OPT_SimulateMultiPass;
 }
 
-void UXOpenGLRenderDevice::DrawTileCoreProgram::CreateInputLayout()
+void UXOpenGLRenderDevice::DrawTileProgram::CreateInputLayout()
 {
-	for (INT i = 0; i < 5; ++i)
-		glEnableVertexAttribArray(i);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DrawTileVertexCore), (GLvoid*)(0));
-	glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(DrawTileVertexCore), (GLvoid*)(offsetof(DrawTileVertexCore, DrawID)));
-	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(DrawTileVertexCore), (GLvoid*)(offsetof(DrawTileVertexCore, TexCoords0)));
-	glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(DrawTileVertexCore), (GLvoid*)(offsetof(DrawTileVertexCore, TexCoords1)));
-	glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(DrawTileVertexCore), (GLvoid*)(offsetof(DrawTileVertexCore, TexCoords2)));
+	CreateDrawIDInputLayout();
 	VertBuffer.SetInputLayoutCreated();
 }
 
-void UXOpenGLRenderDevice::DrawTileCoreProgram::DeactivateShader()
+void UXOpenGLRenderDevice::DrawTileProgram::DeactivateShader()
 {
 	ShaderProgramImpl::DeactivateShader();
 
 #if UNREAL_TOURNAMENT_OLDUNREAL
 	if (!DepthTesting)
-		glEnable(GL_DEPTH_TEST);
+		RenDev->GLState.SetEnabled(GL_DEPTH_TEST, true);
 #endif
 
 	if (RenDev->UseAA && RenDev->NoAATiles)
-		glEnable(GL_MULTISAMPLE);
+		RenDev->GLState.SetEnabled(GL_MULTISAMPLE, true);
 }
 
-void UXOpenGLRenderDevice::DrawTileCoreProgram::ActivateShader()
+void UXOpenGLRenderDevice::DrawTileProgram::ActivateShader()
 {
 	ShaderProgramImpl::ActivateShader();
 
 #if !defined(__EMSCRIPTEN__) && !__LINUX_ARM__
-    if (RenDev->UseAA && RenDev->NoAATiles)
-        glDisable(GL_MULTISAMPLE);
+	if (RenDev->UseAA && RenDev->NoAATiles)
+		RenDev->GLState.SetEnabled(GL_MULTISAMPLE, false);
 #endif
 
 #if UNREAL_TOURNAMENT_OLDUNREAL
 	if (GUglyHackFlags & HACKFLAGS_PostRender) // ugly hack to make the HUD always render on top of weapons
 	{
 		DepthTesting = FALSE;
-		glDisable(GL_DEPTH_TEST);
+		RenDev->GLState.SetEnabled(GL_DEPTH_TEST, false);
 	}
 	else
 	{
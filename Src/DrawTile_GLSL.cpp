@@ -19,7 +19,12 @@ const UXOpenGLRenderDevice::ShaderProgram::DrawCallParameterInfo UXOpenGLRenderD
 {
 	{"vec4", "DrawColor", 0},
 	{"uvec4", "TexHandle", 0},
+	{"vec4", "TileCoords", 0},
+	{"vec4", "TileTexCoords", 0},
+	{"vec2", "TileTexCoordsY", 0},
+	{"float", "TileZ", 0},
 	{"uint", "DrawFlags", 0},
+	{"uint", "ClipPlanes", 0},
 	{"uint", "Dummy0", 0},
 	{"uint", "Dummy1", 0},
 	{"uint", "Dummy2", 0},
@@ -30,77 +35,13 @@ static const char* InterfaceBlockData = R"(
   vec3 Coords;
   vec4 TexCoords;
   vec4 EyeSpacePos;
-
-  // Core only
-  vec4 TexCoords1;
-  vec4 TexCoords2;
-)";
-
-/*-----------------------------------------------------------------------------
-	OpenGL ES Tile Shader
------------------------------------------------------------------------------*/
-
-void UXOpenGLRenderDevice::DrawTileESProgram::BuildVertexShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out)
-{
-	Out << R"(
-out VertexData
-{
-)";
-	Out << InterfaceBlockData;
-	Out << R"(
-} Out;
-
-layout(location = 0) in vec3 Coords; // ==gl_Vertex
-layout(location = 1) in uint DrawID; // emulated gl_DrawID
-layout(location = 2) in vec2 TexCoords;
-
-void main(void)
-{
-  Out.EyeSpacePos = modelviewMat * vec4(Coords, 1.0);
-  Out.TexCoords = vec4(TexCoords, 0.f, 0.f);
-  gl_Position = modelviewprojMat * vec4(Coords, 1.0);
-  vDrawID = DrawID;
-}
-)";
-}
-
-void UXOpenGLRenderDevice::DrawTileESProgram::BuildFragmentShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out)
-{
-	Out << R"(
-layout(location = 0) out vec4 FragColor;
-#if OPT_SimulateMultiPass
-layout ( location = 1 ) out vec4 FragColor1;
-#endif
-
-in VertexData
-{
 )";
-	Out << InterfaceBlockData;
-	Out << R"(
-} In;
-void main(void)
-{	
-  vec4 TotalColor;
-  vec4 Color = GetTexel(GetTexHandle(vDrawID).xy, TMUDiffuse, In.TexCoords.xy);
-  uint DrawFlags = GetDrawFlags(vDrawID);
-
-  TotalColor = ApplyPolyFlags(Color, DrawFlags) * GetDrawColor(vDrawID);
-
-#if OPT_SimulateMultiPass
-  FragColor = TotalColor;
-  FragColor1 = vec4(1.0, 1.0, 1.0, 1.0) - TotalColor;
-#else
-  FragColor = TotalColor;
-#endif
-}
-)";
-}
 
 /*-----------------------------------------------------------------------------
-	OpenGL Core Tile Shader
+	Tile Shader
 -----------------------------------------------------------------------------*/
 
-void UXOpenGLRenderDevice::DrawTileCoreProgram::BuildVertexShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out)
+void UXOpenGLRenderDevice::DrawTileProgram::BuildVertexShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out)
 {
 	Out << R"(
 out VertexData
@@ -110,165 +51,58 @@ out VertexData
 	Out << R"(
 } Out;
 
-layout(location = 0) in vec3 Coords; // ==gl_Vertex
-layout(location = 1) in uint DrawID; // emulated gl_DrawID
-layout(location = 2) in vec4 TexCoords0;
-layout(location = 3) in vec4 TexCoords1;
-layout(location = 4) in vec4 TexCoords2;
-
-void main(void)
-{
-  Out.EyeSpacePos = modelviewMat * vec4(Coords, 1.0);
-  Out.Coords = Coords;
-  Out.TexCoords = TexCoords0;
-  Out.TexCoords1 = TexCoords1;
-  Out.TexCoords2 = TexCoords2;
-  gl_Position = vec4(Coords, 1.0);
-  vDrawID = DrawID;
-}
-)";
-}
-
-void UXOpenGLRenderDevice::DrawTileCoreProgram::BuildGeometryShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out)
-{
-	Out << R"(
-layout(triangles) in;
-layout(triangle_strip, max_vertices = 6) out;
-
-in VertexData
-{
-)";
-	Out << InterfaceBlockData;
-	Out << R"(
-} In[];
-
-out GeometryData
-{
-)";
-	Out << InterfaceBlockData;
-	Out << R"(
-} Out;
-
 #if OPT_ClipDistance
 out float gl_ClipDistance[OPT_MaxClippingPlanes];
 #endif
 
-void main()
-{
-  uint ClipIndex = uint(ClipParams.x);
-
-  float RFX2 = In[0].TexCoords.x;
-  float RFY2 = In[0].TexCoords.y;
-  float FX2 = In[0].TexCoords.z;
-  float FY2 = In[0].TexCoords.w;
-
-  float U = In[0].TexCoords1.x;
-  float V = In[0].TexCoords1.y;
-  float UL = In[0].TexCoords1.z;
-  float VL = In[0].TexCoords1.w;
-
-  float XL = In[0].TexCoords2.x;
-  float YL = In[0].TexCoords2.y;
-  float UMult = In[0].TexCoords2.z;
-  float VMult = In[0].TexCoords2.w;
-
-  float X = gl_in[0].gl_Position.x;
-  float Y = gl_in[0].gl_Position.y;
-  float Z = gl_in[0].gl_Position.z;
-
-  vec3 Position;
+layout(location = 1) in uint DrawID; // instanced attribute. The baseInstance of the draw call selects the DrawID
 
-  gDrawID = vDrawID[0];
+// Two triangles spanning the unit quad. Every tile is one instance of this quad
+const vec2 TileCorners[6] = vec2[6](
+  vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+  vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));
 
-  Out.TexCoords.zw = vec2(0.f, 0.f);
-
-  // 0
-  Position.x = RFX2 * Z * (X - FX2);
-  Position.y = RFY2 * Z * (Y - FY2);
-  Position.z = Z;
-  Out.TexCoords.x = (U)*UMult;
-  Out.TexCoords.y = (V)*VMult;
-  gl_Position = modelviewprojMat * vec4(Position, 1.0);
-#if OPT_ClipDistance
-  gl_ClipDistance[ClipIndex] = PlaneDot(ClipPlane, In[0].Coords);
-#endif
-  EmitVertex();
-
-  // 1
-  Position.x = RFX2 * Z * (X + XL - FX2);
-  Position.y = RFY2 * Z * (Y - FY2);
-  Position.z = Z;
-  Out.TexCoords.x = (U + UL) * UMult;
-  Out.TexCoords.y = (V)*VMult;
-  gl_Position = modelviewprojMat * vec4(Position, 1.0);
-#if OPT_ClipDistance
-  gl_ClipDistance[ClipIndex] = PlaneDot(ClipPlane, In[1].Coords);
-#endif
-  EmitVertex();
-
-  // 2
-  Position.x = RFX2 * Z * (X + XL - FX2);
-  Position.y = RFY2 * Z * (Y + YL - FY2);
-  Position.z = Z;
-  Out.TexCoords.x = (U + UL) * UMult;
-  Out.TexCoords.y = (V + VL) * VMult;
-  gl_Position = modelviewprojMat * vec4(Position, 1.0);
-#if OPT_ClipDistance
-  gl_ClipDistance[ClipIndex] = PlaneDot(ClipPlane, In[2].Coords);
-#endif
-  EmitVertex();
-  EndPrimitive();
+void main(void)
+{
+  vec2 Corner = TileCorners[gl_VertexID % 6];
+  vec4 TileCoords = GetTileCoords(DrawID);
+  vec4 TileTexCoords = GetTileTexCoords(DrawID);
 
-  // 0
-  Position.x = RFX2 * Z * (X - FX2);
-  Position.y = RFY2 * Z * (Y - FY2);
-  Position.z = Z;
-  Out.TexCoords.x = (U)*UMult;
-  Out.TexCoords.y = (V)*VMult;
-  gl_Position = modelviewprojMat * vec4(Position, 1.0);
-#if OPT_ClipDistance
-  gl_ClipDistance[ClipIndex] = PlaneDot(ClipPlane, In[0].Coords);
-#endif
-  EmitVertex();
+  vec3 Position = vec3(TileCoords.xy + Corner * TileCoords.zw, GetTileZ(DrawID));
+  vec2 TexCoords = TileTexCoords.xy + Corner.x * TileTexCoords.zw + Corner.y * GetTileTexCoordsY(DrawID);
 
-  // 2
-  Position.x = RFX2 * Z * (X + XL - FX2);
-  Position.y = RFY2 * Z * (Y + YL - FY2);
-  Position.z = Z;
-  Out.TexCoords.x = (U + UL) * UMult;
-  Out.TexCoords.y = (V + VL) * VMult;
+  Out.Coords = Position;
+  Out.TexCoords = vec4(TexCoords, 0.f, 0.f);
+  Out.EyeSpacePos = modelviewMat * vec4(Position, 1.0);
   gl_Position = modelviewprojMat * vec4(Position, 1.0);
-#if OPT_ClipDistance
-  gl_ClipDistance[ClipIndex] = PlaneDot(ClipPlane, In[1].Coords);
-#endif
-  EmitVertex();
 
-  // 3
-  Position.x = RFX2 * Z * (X - FX2);
-  Position.y = RFY2 * Z * (Y + YL - FY2);
-  Position.z = Z;
-  Out.TexCoords.x = (U)*UMult;
-  Out.TexCoords.y = (V + VL) * VMult;
-  gl_Position = modelviewprojMat * vec4(Position, 1.0);
 #if OPT_ClipDistance
-  gl_ClipDistance[ClipIndex] = PlaneDot(ClipPlane, In[2].Coords);
+  uint ClipPlaneSet = GetClipPlanes(DrawID);
+  for (uint i = 0u; i < uint(OPT_MaxClippingPlanes); ++i)
+    gl_ClipDistance[i] = ClipDistance(ClipPlaneSet, i, Position);
 #endif
-  EmitVertex();  
 
-  EndPrimitive();
+  vDrawID = DrawID;
 }
 )";
 }
 
-void UXOpenGLRenderDevice::DrawTileCoreProgram::BuildFragmentShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out)
+void UXOpenGLRenderDevice::DrawTileProgram::BuildFragmentShader(GLuint ShaderType, UXOpenGLRenderDevice* GL, FShaderWriterX& Out)
 {
 	Out << R"(
-#if OPT_SimulateMultiPass
+#if OPT_GLES
+layout(location = 0) out vec4 FragColor;
+# if OPT_SimulateMultiPass
+layout(location = 1) out vec4 FragColor1;
+# endif
+#else
+# if OPT_SimulateMultiPass
 layout(location = 0, index = 1) out vec4 FragColor1;
-#endif
+# endif
 layout(location = 0, index = 0) out vec4 FragColor;
+#endif
 
-in GeometryData
+in VertexData
 {
 )";
 	Out << InterfaceBlockData;
@@ -277,18 +111,12 @@ in GeometryData
 
 void main(void)
 {
-#if OPT_GeometryShaders
-  uint DrawID = gDrawID;
-#else
-  uint DrawID = vDrawID;
-#endif
-
-  uint DrawFlags = GetDrawFlags(DrawID);
+  uint DrawFlags = GetDrawFlags(vDrawID);
 
   vec4 TotalColor;
-  vec4 Color = GetTexel(GetTexHandle(DrawID).xy, TMUDiffuse, In.TexCoords.xy);
+  vec4 Color = GetTexel(GetTexHandle(vDrawID).xy, TMUDiffuse, In.TexCoords.xy);
 
-  TotalColor = ApplyPolyFlags(Color, DrawFlags) * GetDrawColor(DrawID);
+  TotalColor = ApplyPolyFlags(Color, DrawFlags) * GetDrawColor(vDrawID);
 
 #if OPT_Editor
   if ((DrawFlags & DF_Selected) == DF_Selected)
@@ -298,7 +126,7 @@ void main(void)
   }
 
   if (bool(HitTesting))
-    TotalColor = GetDrawColor(DrawID);
+    TotalColor = GetDrawColor(vDrawID);
 #endif
 
 #if OPT_SimulateMultiPass
@@ -309,4 +137,4 @@ void main(void)
 #endif
 }
 )";
-}
\ No newline at end of file
+}
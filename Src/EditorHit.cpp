@@ -59,7 +59,7 @@ void UXOpenGLRenderDevice::PopHit(INT Count, UBOOL bForce)
 
 	// Force end buffing polygons. This makes sure we won't
 	// draw the buffered polygones under the wrong name.
-	SetProgram(No_Prog);
+	SetProgram(No_Prog, Flush_PopHit);
 	//glFinish();
 
 	// Handle Force hit.
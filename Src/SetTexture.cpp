@@ -38,6 +38,106 @@ static void FixCacheID(FTextureInfo& Info, DWORD PolyFlags)
 	}
 }
 
+// The shaders recognize texture array layers by the 1 in the upper half of their handle
+static GLuint64 ArrayLayerHandle(const UXOpenGLRenderDevice::FCachedTexture* Bind)
+{
+	return (GLuint64(1) << 32) | static_cast<GLuint64>(Bind->ArrayLayer);
+}
+
+static inline INT BindLookasideSlot(QWORD CacheID)
+{
+	DWORD Hash = GetOpenGLTypeHash(CacheID);
+	Hash ^= Hash >> 11;
+	// Keep bit 2 so the masked and non-masked copies of a texture get different slots
+	return static_cast<INT>(Hash >> 2) & (UXOpenGLRenderDevice::BIND_LOOKASIDE_SIZE - 1);
+}
+
+UXOpenGLRenderDevice::FCachedTexture* UXOpenGLRenderDevice::FindCachedTexture(QWORD CacheID)
+{
+	if (RecordingCacheIDs)
+		RecordedCacheIDs.AddItem(CacheID);
+
+	if (BindLookasideSerial != BindMapSerial)
+	{
+		appMemzero(BindLookaside, sizeof(BindLookaside));
+		BindLookasideSerial = BindMapSerial;
+	}
+
+	FBindLookaside& Entry = BindLookaside[BindLookasideSlot(CacheID)];
+	if (Entry.Bind && Entry.CacheID == CacheID)
+		return Entry.Bind;
+
+	// Misses are not remembered. We usually add the texture right after
+	FCachedTexture* Result = BindMap->Find(CacheID);
+	if (Result)
+	{
+		Entry.CacheID = CacheID;
+		Entry.Bind = Result;
+	}
+	return Result;
+}
+
+//
+// BENCHTEXTURELOOKUPS: replays the CacheIDs FindCachedTexture looked up in the last frame,
+// once straight through the BindMap and once through the lookaside. Results are in ns per lookup.
+//
+void UXOpenGLRenderDevice::BenchmarkTextureLookups(FOutputDevice& Ar)
+{
+	guard(UXOpenGLRenderDevice::BenchmarkTextureLookups);
+
+	const INT Count = RecordedCacheIDs.Num();
+	if (!Count)
+	{
+		Ar.Logf(TEXT("XOpenGL: No texture lookups recorded"));
+		return;
+	}
+
+	// Replay about a million lookups per run
+	const INT Iterations = Max(1000000 / Count, 1);
+	const DOUBLE Lookups = (DOUBLE)Iterations * Count;
+	INT Found = 0;
+
+	FTime StartTime = appSeconds();
+	for (INT Iteration = 0; Iteration < Iterations; Iteration++)
+		for (INT i = 0; i < Count; i++)
+			Found += BindMap->Find(RecordedCacheIDs(i)) != nullptr;
+	const FLOAT MapSeconds = appSeconds() - StartTime;
+
+	// Start from an empty lookaside, like the frame did after the last BindMap change.
+	// The first pass tells us how often the frame itself hit
+	BindLookasideSerial = BindMapSerial - 1;
+	INT Hits = 0;
+	for (INT i = 0; i < Count; i++)
+	{
+		const FBindLookaside& Entry = BindLookaside[BindLookasideSlot(RecordedCacheIDs(i))];
+		if (BindLookasideSerial == BindMapSerial && Entry.Bind && Entry.CacheID == RecordedCacheIDs(i))
+			Hits++;
+		FindCachedTexture(RecordedCacheIDs(i));
+	}
+
+	StartTime = appSeconds();
+	for (INT Iteration = 0; Iteration < Iterations; Iteration++)
+		for (INT i = 0; i < Count; i++)
+			Found += FindCachedTexture(RecordedCacheIDs(i)) != nullptr;
+	const FLOAT LookasideSeconds = appSeconds() - StartTime;
+
+	// Both runs find the same textures. Logging the count keeps the compiler from dropping the lookups
+	Ar.Logf(TEXT("XOpenGL: %i texture lookups in the last frame (%i cached), %.1f%% lookaside hits. BindMap %.1f ns/lookup, lookaside %.1f ns/lookup"),
+		Count, Found / (2 * Iterations), 100.0 * Hits / Count, MapSeconds * 1e9 / Lookups, LookasideSeconds * 1e9 / Lookups);
+
+	unguard;
+}
+
+UXOpenGLRenderDevice::FCachedTexture& UXOpenGLRenderDevice::AddCachedTexture(QWORD CacheID)
+{
+	// This can move every entry in the map
+	++BindMapSerial;
+
+	FCachedTexture& Result = BindMap->Set(CacheID, FCachedTexture());
+	memset(&Result, 0, sizeof(FCachedTexture));
+	return Result;
+}
+
 UXOpenGLRenderDevice::FCachedTexture*
 UXOpenGLRenderDevice::GetCachedTextureInfo
 (
@@ -47,17 +147,22 @@ UXOpenGLRenderDevice::GetCachedTextureInfo
 	BOOL& IsResidentBindlessTexture,
 	BOOL& IsBoundToTMU,
 	BOOL& IsTextureDataStale,
-	BOOL ShouldResetStaleState
+	BOOL ShouldResetStaleState,
+	const FResolvedTexture* Resolved
 )
 {
 	FixCacheID(Info, PolyFlags);
-	FCachedTexture* Result = BindMap->Find(Info.CacheID);
+	FCachedTexture* Result = (Resolved && Resolved->BindMapSerial == BindMapSerial && Resolved->CacheID == Info.CacheID) ?
+		Resolved->Bind : FindCachedTexture(Info.CacheID);
 
 	if (UsingBindlessTextures && Result && Result->BindlessTexHandle)
 		IsResidentBindlessTexture = TRUE;
 
-	// The texture is not bindless resident
-	IsBoundToTMU = Result && TexInfo[Multi].CurrentCacheID == Info.CacheID;
+	// The texture is not bindless resident. Texture array layers only need their pool to be bound
+	if (Result && Result->ArrayPool && Multi == DiffuseTextureIndex)
+		IsBoundToTMU = BoundTexturePool == Result->ArrayPool;
+	else
+		IsBoundToTMU = Result && TexInfo[Multi].CurrentCacheID == Info.CacheID;
 
 	// already cached but the texture data may have changed
 	if (Info.bRealtimeChanged)
@@ -97,9 +202,21 @@ UXOpenGLRenderDevice::GetCachedTextureInfo
 }
 
 BOOL UXOpenGLRenderDevice::WillTextureStateChange(INT Multi, FTextureInfo& Info, DWORD PolyFlags)
+{
+	FResolvedTexture Resolved;
+	return CheckTexture(Multi, Info, PolyFlags, Resolved);
+}
+
+//
+// Same as WillTextureStateChange, but remembers the result of the lookup in @Resolved.
+// Passing @Resolved to SetTexture saves it another lookup, provided it uses the same PolyFlags.
+//
+BOOL UXOpenGLRenderDevice::CheckTexture(INT Multi, FTextureInfo& Info, DWORD PolyFlags, FResolvedTexture& Resolved)
 {
 	BOOL IsResidentBindlessTexture = FALSE, IsBoundToTMU = FALSE, IsTextureDataStale = FALSE;
-	GetCachedTextureInfo(Multi, Info, PolyFlags, IsResidentBindlessTexture, IsBoundToTMU, IsTextureDataStale, FALSE);
+	Resolved.Bind = GetCachedTextureInfo(Multi, Info, PolyFlags, IsResidentBindlessTexture, IsBoundToTMU, IsTextureDataStale, FALSE);
+	Resolved.CacheID = Info.CacheID;
+	Resolved.BindMapSerial = BindMapSerial;
 
 	// We need to re-upload a texture we're currently using
 	if (IsTextureDataStale)
@@ -155,10 +272,18 @@ void UXOpenGLRenderDevice::UpdateTextureRect(FTextureInfo& Info, INT U, INT V, I
 	if (!Bind)
 		return;
 
-	if (WillTextureStateChange(-1, Info, 0))
+	// Texture array layers are small. Just upload the whole layer again
+	if (Bind->ArrayPool)
+	{
+		FlushPendingDraws(Flush_Texture);
+		SetTextureArrayLayer(Info, Bind, PF_None, TRUE);
+		return;
+	}
+
+	if (WillTextureStateChange(-1, Info, 0) || DeferredPrograms)
 	{
 		// flush buffered data
-		Shaders[ActiveProgram]->Flush(false);
+		FlushPendingDraws(Flush_Texture);
 	}
 
 	// Use TMU 8 as a temporary storage location
@@ -200,12 +325,104 @@ void UXOpenGLRenderDevice::SetNoTexture( INT Multi )
 	guard(UXOpenGLRenderDevice::SetNoTexture);
 	if( TexInfo[Multi].CurrentCacheID != 0 )
 	{
-		glBindTexture( GL_TEXTURE_2D, 0 );
+		GLState.BindTexture(Multi, 0);
 		TexInfo[Multi].CurrentCacheID = 0;
 	}
 	unguard;
 }
 
+static inline INT TextureLookupSlot(UTexture* Texture)
+{
+	const PTRINT Key = reinterpret_cast<PTRINT>(Texture);
+	return static_cast<INT>((Key >> 4) ^ (Key >> 10)) & (UXOpenGLRenderDevice::TEXTURE_LOOKUP_SIZE - 1);
+}
+
+//
+// Binds @Texture to @Multi using the result of an earlier lookup in this frame.
+// Returns FALSE if the caller has to lock and set the texture the slow way.
+//
+UBOOL UXOpenGLRenderDevice::SetTextureFromLookup(INT Multi, UTexture* Texture)
+{
+	const FTextureLookup& Entry = TextureLookups[TextureLookupSlot(Texture)];
+	if (Entry.Texture != Texture || Entry.Frame != TextureLookupFrame)
+		return FALSE;
+
+#if UNREAL_TOURNAMENT_OLDUNREAL
+	// The texture data changed since we looked it up, so it needs a re-upload
+	if (Entry.RealtimeChangeCount != Texture->RealtimeChangeCount)
+		return FALSE;
+#endif
+
+	// Without a bindless handle, the texture must still be bound to this TMU
+	FTexInfo& Tex = TexInfo[Multi];
+	if (!Entry.BindlessTexHandle && Tex.CurrentCacheID != Entry.CacheID)
+		return FALSE;
+
+	Tex.UMult = Entry.UMult;
+	Tex.VMult = Entry.VMult;
+	Tex.UPan = Entry.UPan;
+	Tex.VPan = Entry.VPan;
+	Tex.BindlessTexHandle = Entry.BindlessTexHandle;
+	return TRUE;
+}
+
+// Remembers the state SetTexture just set for @Texture on @Multi
+void UXOpenGLRenderDevice::AddTextureLookup(INT Multi, UTexture* Texture, FTextureInfo& Info)
+{
+#if !UNREAL_TOURNAMENT_OLDUNREAL
+	// We can't tell if these changed after the lookup
+	if (Texture->bRealtime || Texture->bParametric)
+		return;
+#endif
+
+	const FTexInfo& Tex = TexInfo[Multi];
+	FTextureLookup& Entry = TextureLookups[TextureLookupSlot(Texture)];
+	Entry.Texture = Texture;
+	Entry.Frame = TextureLookupFrame;
+#if UNREAL_TOURNAMENT_OLDUNREAL
+	Entry.RealtimeChangeCount = Texture->RealtimeChangeCount;
+#endif
+	Entry.CacheID = Info.CacheID;
+	Entry.BindlessTexHandle = Tex.BindlessTexHandle;
+	Entry.UMult = Tex.UMult;
+	Entry.VMult = Tex.VMult;
+	Entry.UPan = Tex.UPan;
+	Entry.VPan = Tex.VPan;
+}
+
+// Invalidates all lookups. Called at the start of every frame and whenever we delete textures
+void UXOpenGLRenderDevice::ResetTextureLookups()
+{
+	if (++TextureLookupFrame == 0)
+	{
+		appMemzero(TextureLookups, sizeof(TextureLookups));
+		TextureLookupFrame = 1;
+	}
+}
+
+#if ENGINE_VERSION==227
+//
+// Captures the texture modifier as a 2x3 matrix that the vertex shaders apply to texel space UVs.
+// Modifiers are affine, so transforming the origin and the two unit vectors gives us the whole matrix.
+// Returns false if the texture has no modifier.
+//
+bool UXOpenGLRenderDevice::GetTexModifier(FTextureInfo& Info, glm::vec4* Rows)
+{
+	if (!Info.Modifier)
+		return false;
+
+	FLOAT UM = Info.USize, VM = Info.VSize;
+	FLOAT U0 = 0.f, V0 = 0.f, U1 = 1.f, V1 = 0.f, U2 = 0.f, V2 = 1.f;
+	Info.Modifier->TransformPointUV(U0, V0, UM, VM);
+	Info.Modifier->TransformPointUV(U1, V1, UM, VM);
+	Info.Modifier->TransformPointUV(U2, V2, UM, VM);
+
+	Rows[0] = glm::vec4(U1 - U0, U2 - U0, U0, 0.f);
+	Rows[1] = glm::vec4(V1 - V0, V2 - V0, V0, 0.f);
+	return true;
+}
+#endif
+
 void UXOpenGLRenderDevice::SetSampler(GLuint Sampler, FTextureInfo& Info, UBOOL SkipMipmaps, UBOOL IsLightOrFogMap, UBOOL NoSmooth)
 {
 	guard(UXOpenGLRenderDevice::SetSampler);
@@ -708,12 +925,11 @@ void UXOpenGLRenderDevice::GenerateTextureAndSampler(FCachedTexture* Bind)
 
 void UXOpenGLRenderDevice::BindTextureAndSampler(INT Multi, FCachedTexture* Bind)
 {
-	glActiveTexture(GL_TEXTURE0 + Multi);
-	glBindTexture(GL_TEXTURE_2D, Bind->Id);
-	glBindSampler(Multi, Bind->Sampler);
+	GLState.BindTexture(Multi, Bind->Id);
+	GLState.BindSampler(Multi, Bind->Sampler);
 }
 
-void UXOpenGLRenderDevice::SetTexture(INT Multi, FTextureInfo& Info, DWORD PolyFlags, FLOAT PanBias)
+void UXOpenGLRenderDevice::SetTexture(INT Multi, FTextureInfo& Info, DWORD PolyFlags, FLOAT PanBias, const FResolvedTexture* Resolved)
 {
 	guard(UXOpenGLRenderDevice::SetTexture);
 
@@ -733,12 +949,26 @@ void UXOpenGLRenderDevice::SetTexture(INT Multi, FTextureInfo& Info, DWORD PolyF
 
 	// Check if the texture is already bound to the correct TMU
 	BOOL IsResidentBindlessTexture = FALSE, IsBoundToTMU = FALSE, IsTextureDataStale = FALSE;
-	FCachedTexture* Bind = GetCachedTextureInfo(Multi, Info, PolyFlags, IsResidentBindlessTexture, IsBoundToTMU, IsTextureDataStale, TRUE);
+	FCachedTexture* Bind = GetCachedTextureInfo(Multi, Info, PolyFlags, IsResidentBindlessTexture, IsBoundToTMU, IsTextureDataStale, TRUE, Resolved);
+
+	const UBOOL IsArrayLayer = Bind && Bind->ArrayPool && Multi == DiffuseTextureIndex;
 
 	// Bail out early if the texture is fully up-to-date
 	if (Bind && (IsResidentBindlessTexture || IsBoundToTMU) && !IsTextureDataStale)
 	{
-		Tex.BindlessTexHandle = Bind->BindlessTexHandle;
+		Tex.BindlessTexHandle = IsArrayLayer ? ArrayLayerHandle(Bind) : Bind->BindlessTexHandle;
+		STAT(unclockFast(Stats.BindCycles));
+		return;
+	}
+
+	// We are about to bind or upload a texture. Deferred draw calls might still reference the old contents
+	FlushDeferredPrograms(Flush_Texture);
+
+	// New diffuse textures go into a texture array pool if they fit one
+	if ((IsArrayLayer || (!Bind && Multi == DiffuseTextureIndex && UsingTextureArrays)) &&
+		SetTextureArrayLayer(Info, Bind, PolyFlags, IsTextureDataStale))
+	{
+		Tex.BindlessTexHandle = ArrayLayerHandle(Bind);
 		STAT(unclockFast(Stats.BindCycles));
 		return;
 	}
@@ -749,8 +979,7 @@ void UXOpenGLRenderDevice::SetTexture(INT Multi, FTextureInfo& Info, DWORD PolyF
 	if (!Bind)
 	{
 		// Figure out OpenGL-related scaling for the texture.
-		Bind = &BindMap->Set( Info.CacheID, FCachedTexture() );
-		memset(Bind, 0, sizeof(FCachedTexture));
+		Bind = &AddCachedTexture(Info.CacheID);
 	}
 
 	UBOOL IsNewBind = Bind->Id == 0;
@@ -804,6 +1033,409 @@ void UXOpenGLRenderDevice::SetTexture(INT Multi, FTextureInfo& Info, DWORD PolyF
 	unguard;
 }
 
+/*-----------------------------------------------------------------------------
+	Tile atlas
+-----------------------------------------------------------------------------*/
+
+// Atlas pages are bound with a synthetic CacheID so SetTexture never mistakes them for a regular texture
+static QWORD TileAtlasCacheID(INT Page, DWORD PolyFlags)
+{
+	return (QWORD(0xFFFFFFFFu) << 32) | (QWORD(Page) << 4) | ((PolyFlags & PF_NoSmooth) ? 8 : 0);
+}
+
+UXOpenGLRenderDevice::FTileAtlasEntry* UXOpenGLRenderDevice::GetTileAtlasEntry(FTextureInfo& Info, DWORD PolyFlags, FLOAT U, FLOAT V, FLOAT UL, FLOAT VL)
+{
+	guard(UXOpenGLRenderDevice::GetTileAtlasEntry);
+
+	// Only static, uncompressed textures that we can convert to RGBA8 ourselves
+	if (!Info.Texture || Info.bRealtime || Info.bRealtimeChanged || Info.NumMips <= 0 || !Info.Mips[0] ||
+		(Info.Format != TEXF_P8 && Info.Format != TEXF_BGRA8) ||
+		Info.USize > TILE_ATLAS_MAX_TEXTURE_SIZE || Info.VSize > TILE_ATLAS_MAX_TEXTURE_SIZE)
+		return nullptr;
+
+#if ENGINE_VERSION==227
+	if (Info.Modifier)
+		return nullptr;
+#endif
+
+	// The atlas cannot wrap, so the tile must stay within the bounds of the texture
+	const FLOAT UMax = Info.UScale * Info.USize;
+	const FLOAT VMax = Info.VScale * Info.VSize;
+	if (Min(U, U + UL) < 0.f || Max(U, U + UL) > UMax || Min(V, V + VL) < 0.f || Max(V, V + VL) > VMax)
+		return nullptr;
+
+	FixCacheID(Info, PolyFlags);
+	FTileAtlasEntry* Entry = TileAtlasMap.Find(Info.CacheID);
+	if (Entry)
+		return Entry;
+
+	// Find room for the texture and a 1 texel gutter on every side. The gutter repeats the
+	// edge texels so bilinear filtering does not bleed into neighbouring textures
+	FMipmapBase* Mip = Info.Mips[0];
+	const INT USize = Mip->USize, VSize = Mip->VSize;
+	const INT W = USize + 2, H = VSize + 2;
+	if (USize <= 0 || VSize <= 0 || W > TILE_ATLAS_PAGE_SIZE || H > TILE_ATLAS_PAGE_SIZE)
+		return nullptr;
+
+	INT Page = -1, X = 0, Y = 0;
+	for (INT Pass = 0; Pass < 2 && Page == -1; ++Pass)
+	{
+		for (INT i = 0; i < TileAtlasPages.Num(); ++i)
+		{
+			FTileAtlasPage& P = TileAtlasPages(i);
+			if (P.ShelfX + W > TILE_ATLAS_PAGE_SIZE)
+			{
+				if (P.ShelfY + P.ShelfHeight + H > TILE_ATLAS_PAGE_SIZE)
+					continue;
+				P.ShelfY += P.ShelfHeight;
+				P.ShelfX = P.ShelfHeight = 0;
+			}
+			if (P.ShelfY + H > TILE_ATLAS_PAGE_SIZE)
+				continue;
+
+			Page = i;
+			X = P.ShelfX;
+			Y = P.ShelfY;
+			P.ShelfX += W;
+			P.ShelfHeight = Max(P.ShelfHeight, H);
+			break;
+		}
+
+		if (Page == -1 && TileAtlasPages.Num() < TILE_ATLAS_MAX_PAGES)
+		{
+			FTileAtlasPage& P = TileAtlasPages(TileAtlasPages.AddZeroed());
+			glGenTextures(1, &P.Id);
+			GLState.BindTexture(UploadIndex, P.Id);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, TILE_ATLAS_PAGE_SIZE, TILE_ATLAS_PAGE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+			TexInfo[UploadIndex].CurrentCacheID = 0;
+
+			Page = TileAtlasPages.Num() - 1;
+			P.ShelfX = W;
+			P.ShelfHeight = H;
+		}
+		else if (Page == -1)
+		{
+			// All pages are full. Start over. The pages themselves stay allocated
+			EmptyTileAtlas();
+		}
+	}
+
+	if (Page == -1)
+		return nullptr;
+
+	if (SupportsLazyTextures)
+		Info.Load();
+
+	if (!Mip->DataPtr || (Info.Format == TEXF_P8 && !Info.Palette))
+	{
+		if (SupportsLazyTextures)
+			Info.Unload();
+		return nullptr;
+	}
+
+	FColor  LocalPal[256];
+	FColor* Palette = Info.Palette;
+	if (Info.Format == TEXF_P8 && (PolyFlags & PF_Masked))
+	{
+		appMemcpy(LocalPal, Info.Palette, 256 * sizeof(FColor));
+		LocalPal[0] = FColor(0, 0, 0, 0);
+		Palette = LocalPal;
+	}
+
+	FMemMark Mark(GMem);
+	DWORD* Pixels = new(GMem, W * H) DWORD;
+	DWORD* Out = Pixels;
+	for (INT j = 0; j < H; ++j)
+	{
+		const INT SrcRow = Clamp(j - 1, 0, VSize - 1) * USize;
+		for (INT i = 0; i < W; ++i)
+		{
+			const INT Src = SrcRow + Clamp(i - 1, 0, USize - 1);
+			if (Info.Format == TEXF_P8)
+			{
+				*Out++ = GET_COLOR_DWORD(Palette[Mip->DataPtr[Src]]);
+			}
+			else
+			{
+				FColor Color = ((FColor*)Mip->DataPtr)[Src];
+				Exchange(Color.R, Color.B);
+				*Out++ = *(DWORD*)&Color;
+			}
+		}
+	}
+
+	// Use TMU 8 as a temporary storage location. Draws that were issued before this upload
+	// only reference other parts of the page
+	GLState.BindTexture(UploadIndex, TileAtlasPages(Page).Id);
+	TexInfo[UploadIndex].CurrentCacheID = 0;
+	glTexSubImage2D(GL_TEXTURE_2D, 0, X, Y, W, H, GL_RGBA, GL_UNSIGNED_BYTE, Pixels);
+	Mark.Pop();
+
+	if (SupportsLazyTextures)
+		Info.Unload();
+
+	FTileAtlasEntry& NewEntry = TileAtlasMap.Set(Info.CacheID, FTileAtlasEntry());
+	NewEntry.Page  = Page;
+	NewEntry.X     = X + 1;
+	NewEntry.Y     = Y + 1;
+	NewEntry.USize = USize;
+	NewEntry.VSize = VSize;
+	return &NewEntry;
+
+	unguard;
+}
+
+BOOL UXOpenGLRenderDevice::WillTileAtlasStateChange(FTileAtlasEntry* Entry, DWORD PolyFlags)
+{
+	return TexInfo[DiffuseTextureIndex].CurrentCacheID != TileAtlasCacheID(Entry->Page, PolyFlags);
+}
+
+void UXOpenGLRenderDevice::SetTileAtlasTexture(FTileAtlasEntry* Entry, FTextureInfo& Info, DWORD PolyFlags)
+{
+	guard(UXOpenGLRenderDevice::SetTileAtlasTexture);
+
+	FTexInfo& Tex = TexInfo[DiffuseTextureIndex];
+
+	// Map tile UVs onto the texture's rectangle in the page. DrawTile adds the offset
+	Tex.UMult = Entry->USize / (Info.UScale * Info.USize * TILE_ATLAS_PAGE_SIZE);
+	Tex.VMult = Entry->VSize / (Info.VScale * Info.VSize * TILE_ATLAS_PAGE_SIZE);
+	Tex.UPan = Tex.VPan = 0.f;
+	Tex.BindlessTexHandle = 0;
+
+	const QWORD CacheID = TileAtlasCacheID(Entry->Page, PolyFlags);
+	if (Tex.CurrentCacheID == CacheID)
+		return;
+
+	FlushDeferredPrograms(Flush_Texture);
+
+	const INT Filter = (PolyFlags & PF_NoSmooth) ? 1 : 0;
+	if (!TileAtlasSamplers[Filter])
+	{
+		glGenSamplers(1, &TileAtlasSamplers[Filter]);
+		glSamplerParameteri(TileAtlasSamplers[Filter], GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glSamplerParameteri(TileAtlasSamplers[Filter], GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glSamplerParameteri(TileAtlasSamplers[Filter], GL_TEXTURE_MIN_FILTER, Filter ? GL_NEAREST : GL_LINEAR);
+		glSamplerParameteri(TileAtlasSamplers[Filter], GL_TEXTURE_MAG_FILTER, Filter ? GL_NEAREST : GL_LINEAR);
+	}
+
+	GLState.BindTexture(DiffuseTextureIndex, TileAtlasPages(Entry->Page).Id);
+	GLState.BindSampler(DiffuseTextureIndex, TileAtlasSamplers[Filter]);
+	Tex.CurrentCacheID = CacheID;
+
+	unguard;
+}
+
+void UXOpenGLRenderDevice::EmptyTileAtlas()
+{
+	guard(UXOpenGLRenderDevice::EmptyTileAtlas);
+
+	// Buffered tiles still reference the current contents of the pages
+	if (TileAtlasMap.Num())
+		FlushPendingDraws(Flush_Texture);
+
+	TileAtlasMap.Empty();
+	for (INT i = 0; i < TileAtlasPages.Num(); ++i)
+		TileAtlasPages(i).ShelfX = TileAtlasPages(i).ShelfY = TileAtlasPages(i).ShelfHeight = 0;
+
+	unguard;
+}
+
+void UXOpenGLRenderDevice::DeleteTileAtlas()
+{
+	guard(UXOpenGLRenderDevice::DeleteTileAtlas);
+
+	TileAtlasMap.Empty();
+	for (INT i = 0; i < TileAtlasPages.Num(); ++i)
+		glDeleteTextures(1, &TileAtlasPages(i).Id);
+	TileAtlasPages.Empty();
+
+	for (INT i = 0; i < 2; ++i)
+	{
+		if (TileAtlasSamplers[i])
+			glDeleteSamplers(1, &TileAtlasSamplers[i]);
+		TileAtlasSamplers[i] = 0;
+	}
+
+	unguard;
+}
+
+/*-----------------------------------------------------------------------------
+	Texture array pools
+-----------------------------------------------------------------------------*/
+
+// Every layer of a texture array has the same size and mip chain
+static UBOOL IsTextureArrayCandidate(FTextureInfo& Info, INT MaxTextureSize)
+{
+	if (!Info.Texture || Info.bRealtime || Info.NumMips <= 0 || !Info.Mips[0] ||
+		(Info.Format != TEXF_P8 && Info.Format != TEXF_BGRA8) ||
+		(Info.Format == TEXF_P8 && !Info.Palette))
+		return FALSE;
+
+	const INT USize = Info.Mips[0]->USize, VSize = Info.Mips[0]->VSize;
+	if (USize <= 0 || VSize <= 0 || Max(USize, VSize) > Min<INT>(MaxTextureSize, TEXTURE_POOL_MAX_TEXTURE_SIZE))
+		return FALSE;
+
+	for (INT i = 1; i < Info.NumMips; ++i)
+		if (!Info.Mips[i] || Info.Mips[i]->USize != Max(USize >> i, 1) || Info.Mips[i]->VSize != Max(VSize >> i, 1))
+			return FALSE;
+
+	return TRUE;
+}
+
+BOOL UXOpenGLRenderDevice::SetTextureArrayLayer(FTextureInfo& Info, FCachedTexture*& Bind, DWORD PolyFlags, BOOL IsTextureDataStale)
+{
+	guard(UXOpenGLRenderDevice::SetTextureArrayLayer);
+
+	BOOL IsNewLayer = FALSE;
+	if (!Bind)
+	{
+		if (!IsTextureArrayCandidate(Info, MaxTextureSize))
+			return FALSE;
+
+		// The sampler state is shared by all layers, so it is part of the pool's key
+		DWORD SamplerFlags = (PolyFlags & PF_NoSmooth) ? 1 : 0;
+#if ENGINE_VERSION==227
+		if (Info.UClampMode)
+			SamplerFlags |= 2;
+		if (Info.VClampMode)
+			SamplerFlags |= 4;
+#endif
+		const INT USize = Info.Mips[0]->USize, VSize = Info.Mips[0]->VSize;
+
+		INT Pool = INDEX_NONE;
+		for (INT i = 0; i < TexturePools.Num(); ++i)
+		{
+			const FTexturePool& P = TexturePools(i);
+			if (P.USize == USize && P.VSize == VSize && P.NumLevels == Info.NumMips &&
+				P.SamplerFlags == SamplerFlags && P.NumLayers < P.MaxLayers)
+			{
+				Pool = i;
+				break;
+			}
+		}
+
+		if (Pool == INDEX_NONE)
+		{
+			Pool = TexturePools.AddZeroed();
+			FTexturePool& P = TexturePools(Pool);
+			P.USize = USize;
+			P.VSize = VSize;
+			P.NumLevels = Info.NumMips;
+			P.SamplerFlags = SamplerFlags;
+
+			INT LayerBytes = 0;
+			for (INT i = 0; i < P.NumLevels; ++i)
+				LayerBytes += Max(USize >> i, 1) * Max(VSize >> i, 1) * 4;
+			P.MaxLayers = Clamp(TEXTURE_POOL_BYTES / LayerBytes, 1, TEXTURE_POOL_MAX_LAYERS);
+
+			glGenTextures(1, &P.Id);
+			GLState.BindTexture(TextureArrayIndex, P.Id, GL_TEXTURE_2D_ARRAY);
+			for (INT i = 0; i < P.NumLevels; ++i)
+				glTexImage3D(GL_TEXTURE_2D_ARRAY, i, GL_RGBA8, Max(USize >> i, 1), Max(VSize >> i, 1), P.MaxLayers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, P.NumLevels - 1);
+
+			glGenSamplers(1, &P.Sampler);
+			SetSampler(P.Sampler, Info, P.NumLevels == 1 && !AlwaysMipmap, FALSE, (SamplerFlags & 1) ? TRUE : FALSE);
+
+			debugf(NAME_DevGraphics, TEXT("XOpenGL: Created texture array pool %i (%ix%i, %i mips, %i layers)"), Pool, USize, VSize, P.NumLevels, P.MaxLayers);
+		}
+
+		Bind = &AddCachedTexture(Info.CacheID);
+		Bind->ArrayPool = Pool + 1;
+		Bind->ArrayLayer = TexturePools(Pool).NumLayers++;
+		IsNewLayer = TRUE;
+	}
+
+	// Callers have flushed the draws that used the previous pool
+	const FTexturePool& P = TexturePools(Bind->ArrayPool - 1);
+	GLState.BindTexture(TextureArrayIndex, P.Id, GL_TEXTURE_2D_ARRAY);
+	GLState.BindSampler(TextureArrayIndex, P.Sampler);
+	BoundTexturePool = Bind->ArrayPool;
+
+	STAT(clockFast(Stats.ImageCycles));
+	if (IsNewLayer || Info.bRealtimeChanged || IsTextureDataStale)
+		UploadTextureArrayLayer(Info, Bind, PolyFlags);
+	STAT(unclockFast(Stats.ImageCycles));
+
+	return TRUE;
+	unguard;
+}
+
+BOOL UXOpenGLRenderDevice::UploadTextureArrayLayer(FTextureInfo& Info, FCachedTexture* Bind, DWORD PolyFlags)
+{
+	guard(UXOpenGLRenderDevice::UploadTextureArrayLayer);
+
+	if (SupportsLazyTextures)
+		Info.Load();
+
+	Info.bRealtimeChanged = 0;
+
+	FColor  LocalPal[256];
+	FColor* Palette = Info.Palette;
+	if (Info.Format == TEXF_P8 && (PolyFlags & PF_Masked))
+	{
+		appMemcpy(LocalPal, Info.Palette, 256 * sizeof(FColor));
+		LocalPal[0] = FColor(0, 0, 0, 0);
+		Palette = LocalPal;
+	}
+
+	// The pool holds RGBA8 texels, which GL ES cannot unpack from BGRA8 either
+	BOOL Result = TRUE;
+	FMemMark Mark(GMem);
+	DWORD* Data = new(GMem, Info.Mips[0]->USize * Info.Mips[0]->VSize) DWORD;
+	for (INT MipIndex = 0; MipIndex < TexturePools(Bind->ArrayPool - 1).NumLevels; ++MipIndex)
+	{
+		FMipmapBase* Mip = Info.Mips[MipIndex];
+		if (!Mip->DataPtr)
+		{
+			GWarn->Logf(TEXT("Unpacking %ls on %ls failed due to invalid data."), *FTextureFormatString(Info.Format), Info.Texture->GetFullName());
+			Result = FALSE;
+			break;
+		}
+
+		const INT Count = Mip->USize * Mip->VSize;
+		if (Info.Format == TEXF_P8)
+		{
+			for (INT i = 0; i < Count; i++)
+				Data[i] = GET_COLOR_DWORD(Palette[Mip->DataPtr[i]]);
+		}
+		else
+		{
+			for (INT i = 0; i < Count; i++)
+			{
+				FColor Color = ((FColor*)Mip->DataPtr)[i];
+				Exchange(Color.R, Color.B);
+				Data[i] = *(DWORD*)&Color;
+			}
+		}
+
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, MipIndex, 0, 0, Bind->ArrayLayer, Mip->USize, Mip->VSize, 1, GL_RGBA, GL_UNSIGNED_BYTE, Data);
+	}
+	Mark.Pop();
+
+	if (SupportsLazyTextures)
+		Info.Unload();
+
+	return Result;
+	unguard;
+}
+
+void UXOpenGLRenderDevice::DeleteTexturePools()
+{
+	guard(UXOpenGLRenderDevice::DeleteTexturePools);
+
+	for (INT i = 0; i < TexturePools.Num(); ++i)
+	{
+		glDeleteTextures(1, &TexturePools(i).Id);
+		glDeleteSamplers(1, &TexturePools(i).Sampler);
+	}
+	TexturePools.Empty();
+	BoundTexturePool = 0;
+
+	unguard;
+}
+
 DWORD UXOpenGLRenderDevice::GetPolyFlagsAndDrawFlags(DWORD PolyFlags, DWORD& DrawFlags, BOOL RemoveOccludeIfSolid)
 {
 	if ((PolyFlags & (PF_RenderFog | PF_Translucent)) != PF_RenderFog)
@@ -861,19 +1493,23 @@ void UXOpenGLRenderDevice::SetBlend(DWORD PolyFlags)
 	// For UED selection disable any blending.
 	if (HitTesting())
 	{
-		glBlendFunc(GL_ONE, GL_ZERO);
+		GLState.SetBlendFunc(GL_ONE, GL_ZERO);
 		return;
 	}
 
+	// Deferred draw calls were buffered for the current blending state
+	if (DeferredPrograms && WillBlendStateChange(CurrentBlendPolyFlags, PolyFlags))
+		FlushDeferredPrograms(Flush_Blend);
+
 	// Check to disable culling or other frontface if needed (or more other affecting states yet). Perhaps should add own RenderFlags if so.
 	DWORD Xor = CurrentBlendPolyFlags ^ PolyFlags;
 	if (Xor & (PF_TwoSided | PF_RenderHint))
 	{
 #if ENGINE_VERSION==227
 		if (PolyFlags & PF_TwoSided)
-			glDisable(GL_CULL_FACE);
+			GLState.SetEnabled(GL_CULL_FACE, false);
 		else
-			glEnable(GL_CULL_FACE);
+			GLState.SetEnabled(GL_CULL_FACE, true);
 #endif
 		CurrentBlendPolyFlags = PolyFlags;
 	}
@@ -886,55 +1522,55 @@ void UXOpenGLRenderDevice::SetBlend(DWORD PolyFlags)
 			if (!(PolyFlags & (PF_Invisible | PF_Translucent | PF_Modulated | PF_AlphaBlend | PF_Highlighted)))
 			{
 				//instead of forcing permanent state changes when disabling glBend use this as default state. Also fixes some flickering due to these changes.
-				glBlendFunc(GL_ONE, GL_CONSTANT_COLOR);
-				glBlendColor(0.0, 0.0, 0.0, 0.0);//actually add...nothing :)
+				GLState.SetBlendFunc(GL_ONE, GL_CONSTANT_COLOR);
+				GLState.SetBlendColor(0.f, 0.f, 0.f, 0.f);//actually add...nothing :)
 			}
 			else if (PolyFlags & PF_Invisible)
 			{
-				glBlendFunc(GL_ZERO, GL_ONE);
+				GLState.SetBlendFunc(GL_ZERO, GL_ONE);
 			}
 			else if (PolyFlags & PF_Translucent)
 			{
                 if (SimulateMultiPass)//( !(PolyFlags & PF_Mirrored)
                 {
                     //debugf(TEXT("PolyFlags %ls ActiveProgram %i"), *GetPolyFlagString(PolyFlags), ActiveProgram);
-					glBlendFunc(GL_SRC_ALPHA, GL_SRC1_COLOR);
+					GLState.SetBlendFunc(GL_SRC_ALPHA, GL_SRC1_COLOR);
                 }
-                else glBlendFunc( GL_ONE, GL_ONE_MINUS_SRC_COLOR );
+                else GLState.SetBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_COLOR);
                 /*
                 else
                 {
-                    glBlendFunc( GL_ZERO, GL_SRC_COLOR ); //Mirrors!
+                    GLState.SetBlendFunc(GL_ZERO, GL_SRC_COLOR); //Mirrors!
                     //debugf(TEXT("Mirror"));
                 }
                 */
 			}
 			else if (PolyFlags & PF_Modulated)
 			{
-				glBlendFunc(GL_DST_COLOR, GL_SRC_COLOR);
+				GLState.SetBlendFunc(GL_DST_COLOR, GL_SRC_COLOR);
 			}
 			else if (PolyFlags & PF_AlphaBlend)
 			{
-				glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+				GLState.SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 			}
 			else if (PolyFlags & PF_Highlighted)
 			{
-				glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+				GLState.SetBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 			}
 		}
 		if (Xor & PF_Invisible)
 		{
 			if (PolyFlags & PF_Invisible)
-				glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+				GLState.SetColorMask(false);
 			else
-				glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+				GLState.SetColorMask(true);
 		}
 		if (Xor & PF_Occlude)
 		{
 			if (PolyFlags & PF_Occlude)
-				glDepthMask(GL_TRUE);
+				GLState.SetDepthMask(true);
 			else
-				glDepthMask(GL_FALSE);
+				GLState.SetDepthMask(false);
 		}
 		CurrentBlendPolyFlags = PolyFlags;
 	}
@@ -955,12 +1591,20 @@ BYTE UXOpenGLRenderDevice::SetZTestMode(BYTE Mode)
 	if (LastZMode == Mode || Mode > 6)
 		return Mode;
 
-	// Flush any pending render.
-	auto CurrentProgram = ActiveProgram;
-	SetProgram(No_Prog);
-	SetProgram(CurrentProgram);
+	// Deferred draw calls would end up on the wrong side of the depth function change
+	FlushDeferredPrograms(Flush_ZTest);
+
+	// The active program keeps batching. The draw calls it queued so far become a sub-batch
+	// that it issues with the old depth function
+	auto Shader = Shaders[ActiveProgram];
+	if (LastZMode > 6 || !Shader->DrawBuffer.SplitDepthFunc(ModeList[LastZMode], ModeList[Mode]))
+	{
+		auto CurrentProgram = ActiveProgram;
+		SetProgram(No_Prog, Flush_ZTest);
+		SetProgram(CurrentProgram);
+	}
 
-	glDepthFunc(ModeList[Mode]);
+	GLState.SetDepthFunc(ModeList[Mode]);
 	BYTE Prev = LastZMode;
 	LastZMode = Mode;
 	return Prev;
@@ -979,8 +1623,8 @@ DWORD UXOpenGLRenderDevice::SetDepth(DWORD LineFlags)
 		if (LineFlags & LINE_DepthCued)
 		{
 			LastZMode = ZTEST_LessEqual;
-			glDepthFunc(GL_LEQUAL);
-			glDepthMask(GL_TRUE);
+			GLState.SetDepthFunc(GL_LEQUAL);
+			GLState.SetDepthMask(true);
 
 			// Sync with SetBlend.
 			CurrentBlendPolyFlags |= PF_Occlude;
@@ -988,8 +1632,8 @@ DWORD UXOpenGLRenderDevice::SetDepth(DWORD LineFlags)
 		else
 		{
 			LastZMode = ZTEST_Always;
-			glDepthFunc(GL_ALWAYS);
-			glDepthMask(GL_FALSE);
+			GLState.SetDepthFunc(GL_ALWAYS);
+			GLState.SetDepthMask(false);
 
 			// Sync with SetBlend.
 			CurrentBlendPolyFlags &= ~PF_Occlude;
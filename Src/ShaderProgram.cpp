@@ -76,6 +76,8 @@ precision lowp int;
 #endif
 	Out << "#define ENGINE_VERSION " << ENGINE_VERSION << END_LINE;	
 	Out << "#define MAX_LIGHTS " << MAX_LIGHTS << END_LINE;	
+	Out << "#define MAX_CLIP_PLANES " << MAX_CLIP_PLANES << END_LINE;
+	Out << "#define MAX_DISTANCE_FOGS " << MAX_DISTANCE_FOGS << END_LINE;
 
 	// Editor rendering modes
 	Out << "#define REN_None " << REN_None << "u" << END_LINE;
@@ -115,6 +117,10 @@ precision lowp int;
 	Out << "#define DF_RenderFog " << ShaderDrawFlags::DF_RenderFog << "u" << END_LINE;
 	Out << "#define DF_AlphaBlended " << ShaderDrawFlags::DF_AlphaBlended << "u" << END_LINE;
 	Out << "#define DF_Selected " << ShaderDrawFlags::DF_Selected << "u" << END_LINE;
+	Out << "#define DF_StaticGeometry " << ShaderDrawFlags::DF_StaticGeometry << "u" << END_LINE;
+	Out << "#define DF_NearZ " << ShaderDrawFlags::DF_NearZ << "u" << END_LINE;
+	Out << "#define DF_EnvironmentUV " << ShaderDrawFlags::DF_EnvironmentUV << "u" << END_LINE;
+	Out << "#define DF_TexModifier " << ShaderDrawFlags::DF_TexModifier << "u" << END_LINE;
 
 	// Texture indices into the texhandles array
 	Out << "#define DiffuseTextureIndex " << DiffuseTextureIndex << "u" << END_LINE;
@@ -144,6 +150,7 @@ layout(std140) uniform FrameState
   mat4 modelMat;
   mat4 modelviewMat;
   mat4 modelviewprojMat;
+  mat4 modelviewprojMatNearZ;
   mat4 lightSpaceMat;
   mat4 FrameCoords;
   mat4 FrameUncoords;
@@ -155,6 +162,8 @@ layout(std140) uniform FrameState
 
 	for (INT i = 0; i < NumTextureSamplers; ++i)
 		Out << "uniform sampler2D Texture" << i << ";" << END_LINE;
+	if (Options.HasOption(ShaderCompilationOptions::OPT_TextureArrays))
+		Out << "uniform mediump sampler2DArray TextureArray;" << END_LINE;
 
 	Out << R"(
 // Light information.
@@ -170,8 +179,7 @@ layout(std140) uniform LightInfo
 
 layout(std140) uniform ClipPlaneParams
 {
-  vec4  ClipParams; // Clipping params, ClipIndex,0,0,0
-  vec4  ClipPlane;  // Clipping planes. Plane.X, Plane.Y, Plane.Z, Plane.W
+  vec4  ClipPlanes[MAX_CLIP_PLANES]; // Plane.X, Plane.Y, Plane.Z, Plane.W
 };
 
 #if OPT_Editor
@@ -182,25 +190,30 @@ layout(std140) uniform EditorState
 };
 #endif
 
+struct DistanceFogInfo
+{
+	vec4 Color;
+	float Start;			// Only for linear fog
+	float End;				// Only for linear fog
+	float Density;			// For exp and exp2 equation
+	int Mode;				// -1 = disabled, 0 = linear, 1 = exp, 2 = exp2
+};
+
 layout(std140) uniform DistanceFogParams
 {
-	vec4 DistanceFogColor;
-	float DistanceFogStart;			// Only for linear fog
-	float DistanceFogEnd;			// Only for linear fog
-	float DistanceFogDensity;		// For exp and exp2 equation
-	int DistanceFogMode;			// -1 = disabled, 0 = linear, 1 = exp, 2 = exp2
+	DistanceFogInfo DistanceFogs[MAX_DISTANCE_FOGS]; // Entry 0 is always disabled
 };
 
 #if OPT_DistanceFog
-float getFogFactor(float FogCoord)
+float getFogFactor(DistanceFogInfo Fog, float FogCoord)
 {
   float FogResult = 1.0;
-  if (DistanceFogMode == 0)
-    FogResult = ((DistanceFogEnd - FogCoord) / (DistanceFogEnd - DistanceFogStart));
-  else if (DistanceFogMode == 1)
-    FogResult = exp(-DistanceFogDensity * FogCoord);
-  else if (DistanceFogMode == 2)
-    FogResult = exp(-pow(DistanceFogDensity * FogCoord, 2.0));
+  if (Fog.Mode == 0)
+    FogResult = ((Fog.End - FogCoord) / (Fog.End - Fog.Start));
+  else if (Fog.Mode == 1)
+    FogResult = exp(-Fog.Density * FogCoord);
+  else if (Fog.Mode == 2)
+    FogResult = exp(-pow(Fog.Density * FogCoord, 2.0));
   FogResult = 1.0 - clamp(FogResult, 0.0, 1.0);
   return FogResult;
 }
@@ -211,6 +224,15 @@ float PlaneDot(vec4 Plane, vec3 Point)
   return dot(Plane.xyz, Point) - Plane.w;
 }
 
+// Distance of @Point to the @Index'th plane of @PlaneSet (FirstPlane | (NumPlanes << 16)).
+// Planes the set does not use never clip
+float ClipDistance(uint PlaneSet, uint Index, vec3 Point)
+{
+  if (Index >= (PlaneSet >> 16))
+    return 1.0;
+  return PlaneDot(ClipPlanes[(PlaneSet & 0xFFFFu) + Index], Point);
+}
+
 vec4 GammaCorrect(float Gamma, vec4 Color)
 {
     float InvGamma = 1.0 / Gamma;
@@ -242,6 +264,14 @@ vec4 GetTexel(uvec2 BindlessTexHandle, sampler2D BoundSampler, vec2 TexCoords)
 {
   return texture(sampler2D(BindlessTexHandle), TexCoords);
 }
+#elif OPT_TextureArrays
+// Layers of the texture array have a 1 in the upper half of their handle and the layer index in the lower half
+vec4 GetTexel(uvec2 BindlessTexHandle, sampler2D BoundSampler, vec2 TexCoords)
+{
+  if (BindlessTexHandle.y != 0u)
+    return texture(TextureArray, vec3(TexCoords, float(BindlessTexHandle.x)));
+  return texture(BoundSampler, TexCoords);
+}
 #else
 // texture bound to TMU. BindlessTexBum is meaningless here
 vec4 GetTexel(uvec2 BindlessTexHandle, sampler2D BoundSampler, vec2 TexCoords)
@@ -341,20 +371,33 @@ INT UXOpenGLRenderDevice::ShaderProgram::GetMaximumUniformBufferSize(const DrawC
 	return 16;
 }
 
-void UXOpenGLRenderDevice::ShaderProgram::EmitDrawCallParametersHeader
+//
+// Emits the struct, buffer block and getters for one array of per-draw data. The block is
+// called All<ShaderName><BlockSuffix> and holds the array Draw<ShaderName><ArraySuffix>.
+// The getters take a DrawID and use @IndexExpr to find the array element
+//
+static void EmitParametersBlock
 (
-	const DrawCallParameterInfo* Info, 
-	FShaderWriterX& Out, 
-	ShaderProgram* Program, 
-	INT BufferBindingIndex, 
-	bool UseSSBO, 
-	bool EmitGetters
+	const UXOpenGLRenderDevice::ShaderProgram::DrawCallParameterInfo* Info,
+	FShaderWriterX& Out,
+	const TCHAR* ProgramName,
+	const char* StructName,
+	const char* BlockSuffix,
+	const char* ArraySuffix,
+	INT ArraySize,
+	INT BufferBindingIndex,
+	bool UseSSBO,
+	bool EmitGetters,
+	const char* IndexExpr
 )
 {
-	// Emit draw call parameters struct
-	Out << R"(struct DrawCallParameters
-{
-)";
+	// Keep our own copy. appToAnsi hands out temporary buffers
+	ANSICHAR ShaderName[256];
+	strncpy(ShaderName, appToAnsi(ProgramName), ARRAY_COUNT(ShaderName) - 1);
+	ShaderName[ARRAY_COUNT(ShaderName) - 1] = '\0';
+
+	// Emit parameters struct
+	Out << "struct " << StructName << END_LINE << "{" END_LINE;
 
 	auto OrigInfo = Info;
 	while (true)
@@ -376,9 +419,9 @@ void UXOpenGLRenderDevice::ShaderProgram::EmitDrawCallParametersHeader
 	if (UseSSBO)
 	{
 		Out << R"(
-layout(std430, binding = )" << BufferBindingIndex << R"() buffer All)" << appToAnsi(Program->ShaderName) << R"(ShaderDrawParams
+layout(std430, binding = )" << BufferBindingIndex << R"() buffer All)" << ShaderName << BlockSuffix << R"(
 {
-  DrawCallParameters Draw)" << appToAnsi(Program->ShaderName) << R"(Params[];
+  )" << StructName << " Draw" << ShaderName << ArraySuffix << R"([];
 };
 )";
 	}
@@ -386,9 +429,9 @@ layout(std430, binding = )" << BufferBindingIndex << R"() buffer All)" << appToA
 	{
 		//, binding = )" << BufferBindingIndex << R"(
 		Out << R"(
-layout(std140) uniform All)" << appToAnsi(Program->ShaderName) << R"(ShaderDrawParams
+layout(std140) uniform All)" << ShaderName << BlockSuffix << R"(
 {
-  DrawCallParameters Draw)"	<< appToAnsi(Program->ShaderName) << R"(Params[)" << Program->ParametersBufferSize << R"(];
+  )" << StructName << " Draw" << ShaderName << ArraySuffix << "[" << ArraySize << R"(];
 };
 )";
 	}
@@ -410,8 +453,9 @@ layout(std140) uniform All)" << appToAnsi(Program->ShaderName) << R"(ShaderDrawP
 		Out << "{" END_LINE;
 
 		Out << "  return Draw"
-			<< appToAnsi(Program->ShaderName)
-			<< "Params[DrawID]."
+			<< ShaderName
+			<< ArraySuffix
+			<< "[" << IndexExpr << "]."
 			<< Info->Name;
 		if (Info->ArrayCount > 0)
 			Out << "[Index]";
@@ -422,6 +466,34 @@ layout(std140) uniform All)" << appToAnsi(Program->ShaderName) << R"(ShaderDrawP
 	}
 }
 
+void UXOpenGLRenderDevice::ShaderProgram::EmitDrawCallParametersHeader
+(
+	const DrawCallParameterInfo* Info, 
+	FShaderWriterX& Out, 
+	ShaderProgram* Program, 
+	INT BufferBindingIndex, 
+	bool UseSSBO, 
+	bool EmitGetters
+)
+{
+	EmitParametersBlock(Info, Out, Program->ShaderName, "DrawCallParameters", "ShaderDrawParams", "Params",
+		Program->ParametersBufferSize, BufferBindingIndex, UseSSBO, EmitGetters, "DrawID");
+}
+
+void UXOpenGLRenderDevice::ShaderProgram::EmitMaterialsHeader
+(
+	const DrawCallParameterInfo* Info,
+	FShaderWriterX& Out,
+	ShaderProgram* Program,
+	INT BufferBindingIndex,
+	bool UseSSBO
+)
+{
+	// The drawcall parameters must have a MaterialIndex field
+	EmitParametersBlock(Info, Out, Program->ShaderName, "MaterialParameters", "ShaderMaterials", "Materials",
+		Program->MaterialsBufferSize, BufferBindingIndex, UseSSBO, true, "GetMaterialIndex(DrawID)");
+}
+
 // Helpers
 void UXOpenGLRenderDevice::ShaderProgram::BindUniform(CompiledShader* Specialization, const GLuint BindingIndex, const char* Name) const
 {
@@ -491,6 +563,8 @@ bool UXOpenGLRenderDevice::ShaderProgram::CompileShaderFunction(GLuint ShaderFun
 
 	if (ParametersInfo)
 		EmitDrawCallParametersHeader(ParametersInfo, ShOut, this, ParametersBufferBindingIndex, UseSSBOParametersBuffer, true);
+	if (MaterialsInfo)
+		EmitMaterialsHeader(MaterialsInfo, ShOut, this, MaterialsBufferBindingIndex, UseSSBOParametersBuffer);
 
 	(*Func)(FunctionType, RenDev, ShOut);
 
@@ -575,9 +649,8 @@ void UXOpenGLRenderDevice::InitShaders()
 	Shaders[No_Prog]				= new NoProgram(TEXT("No"), this);
 	Shaders[Simple_Triangle_Prog]	= new DrawSimpleTriangleProgram(TEXT("DrawSimpleTriangle"), this);
 	Shaders[Simple_Line_Prog]		= new DrawSimpleLineProgram(TEXT("DrawSimpleLine"), this);
-	Shaders[Tile_Prog]				= (OpenGLVersion == GL_Core && UsingGeometryShaders)
-		? static_cast<ShaderProgram*>(new DrawTileCoreProgram(TEXT("DrawTile"), this))
-		: static_cast<ShaderProgram*>(new DrawTileESProgram(TEXT("DrawTile"), this));
+	Shaders[Simple_Point_Prog]		= new DrawSimplePointProgram(TEXT("DrawSimplePoint"), this);
+	Shaders[Tile_Prog]				= new DrawTileProgram(TEXT("DrawTile"), this);
 	Shaders[PostProcess_Prog]		= new PostProcessProgram(TEXT("PostProcess"), this);
 	Shaders[Gouraud_Prog]			= new DrawGouraudProgram(TEXT("DrawGouraud"), this);
 	Shaders[Complex_Prog]			= new DrawComplexProgram(TEXT("DrawComplex"), this);
@@ -610,6 +683,7 @@ void UXOpenGLRenderDevice::InitShaders()
 		GlobalClipPlaneBuffer.GenerateUBOBuffer(this, GlobalShaderBindingIndices::ClipPlaneIndex);
 		GlobalClipPlaneBuffer.MapUBOBuffer(false, 1);
 		GlobalClipPlaneBuffer.Advance(1);
+		ClipPlanesDirty = true;
 	}
 	else
 	{
@@ -636,6 +710,7 @@ void UXOpenGLRenderDevice::InitShaders()
 		DistanceFogBuffer.GenerateUBOBuffer(this, GlobalShaderBindingIndices::DistanceFogInfoIndex);
 		DistanceFogBuffer.MapUBOBuffer(false, 1);
 		DistanceFogBuffer.Advance(1);
+		EmptyDistanceFogTable();
 	}
 	else
 	{
@@ -664,6 +739,7 @@ void UXOpenGLRenderDevice::ResetShaders()
 	for (const auto Shader: Shaders)
 		delete Shader;
 	memset(Shaders, 0, sizeof(ShaderProgram*) * ARRAY_COUNT(Shaders));
+	DeferredPrograms = 0;
 		
 	unguard;
 }
@@ -696,6 +772,8 @@ void UXOpenGLRenderDevice::ShaderProgram::BindShaderState(CompiledShader* Specia
 
 	if (!UseSSBOParametersBuffer && ParametersInfo)
 		BindUniform(Specialization, ParametersBufferBindingIndex, appToAnsi(*FString::Printf(TEXT("All%lsShaderDrawParams"), ShaderName)));
+	if (!UseSSBOParametersBuffer && MaterialsInfo)
+		BindUniform(Specialization, MaterialsBufferBindingIndex, appToAnsi(*FString::Printf(TEXT("All%lsShaderMaterials"), ShaderName)));
 
 	// Bind regular texture samplers to their respective TMUs
 	check(NumTextureSamplers >= 0 && NumTextureSamplers < 9);
@@ -706,11 +784,19 @@ void UXOpenGLRenderDevice::ShaderProgram::BindShaderState(CompiledShader* Specia
 		if (MultiTextureUniform != -1)
 			glUniform1i(MultiTextureUniform, i);
 	}
+
+	if (Specialization->Options.HasOption(ShaderCompilationOptions::OPT_TextureArrays))
+	{
+		GLint TextureArrayUniform;
+		GetUniformLocation(Specialization, TextureArrayUniform, "TextureArray");
+		if (TextureArrayUniform != -1)
+			glUniform1i(TextureArrayUniform, TextureArrayIndex);
+	}
 }
 
 void UXOpenGLRenderDevice::ShaderProgram::UseShader()
 {
-	glUseProgram(CurrentSpecialization->ShaderProgramObject);
+	RenDev->GLState.UseProgram(CurrentSpecialization->ShaderProgramObject);
 }
 
 void UXOpenGLRenderDevice::ShaderProgram::RecompileShader(ShaderCompilationOptions Options)
@@ -735,7 +821,7 @@ void UXOpenGLRenderDevice::ShaderProgram::RecompileShader(ShaderCompilationOptio
 	CurrentSpecialization->ShaderName = FString::Printf(TEXT("%ls%ls"), ShaderName, *Options.GetShortString());
 
 	check(BuildShaderProgram(CurrentSpecialization, VertexShaderFunc, GeoShaderFunc, FragmentShaderFunc));
-	glUseProgram(CurrentSpecialization->ShaderProgramObject);
+	RenDev->GLState.UseProgram(CurrentSpecialization->ShaderProgramObject);
 	BindShaderState(CurrentSpecialization);
 }
 
@@ -793,6 +879,7 @@ void UXOpenGLRenderDevice::ShaderProgram::DeleteShader()
 		glDetachShader(CurrentSpecialization->ShaderProgramObject, CurrentSpecialization->FragmentShaderObject);
 
 	glDeleteProgram(CurrentSpecialization->ShaderProgramObject);
+	RenDev->GLState.InvalidateProgram();
 
 	delete CurrentSpecialization;
 }
@@ -800,6 +887,159 @@ void UXOpenGLRenderDevice::ShaderProgram::DeleteShader()
 UXOpenGLRenderDevice::ShaderProgram::~ShaderProgram()
 = default;
 
+/*-----------------------------------------------------------------------------
+    Static Geometry
+-----------------------------------------------------------------------------*/
+void UXOpenGLRenderDevice::ShaderProgram::MapStaticBuffers(INT VertexSize, INT NumVertices)
+{
+	if (StaticVAO)
+		return;
+
+	// The static VAO is not tracked by the BoundBuffer system, so make sure
+	// the streaming VAO gets rebound when we switch back to it
+	if (RenDev->ArrayPoint)
+		RenDev->ArrayPoint->Unbind();
+
+	StaticVertexSize = VertexSize;
+	StaticVertexBufferSize = NumVertices;
+	NumStaticVertices = 0;
+
+	glGenVertexArrays(1, &StaticVAO);
+	glBindVertexArray(StaticVAO);
+
+	glGenBuffers(1, &StaticVertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, StaticVertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(NumVertices) * VertexSize, nullptr, GL_STATIC_DRAW);
+	CreateStaticInputLayout();
+	CreateDrawIDInputLayout();
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+void UXOpenGLRenderDevice::ShaderProgram::UnmapStaticBuffers()
+{
+	if (StaticVAO)
+	{
+		glDeleteVertexArrays(1, &StaticVAO);
+		StaticVAO = 0;
+	}
+	if (StaticVertexBuffer)
+	{
+		glDeleteBuffers(1, &StaticVertexBuffer);
+		StaticVertexBuffer = 0;
+	}
+	NumStaticVertices = 0;
+}
+
+INT UXOpenGLRenderDevice::ShaderProgram::UploadStaticVertices(const void* Vertices, INT NumVertices)
+{
+	// Callers must make room before they start preparing a draw call. Flushing in here would drop their parameters
+	check(NumStaticVertices + NumVertices <= StaticVertexBufferSize);
+
+	// Use the copy binding point so we do not disturb the GL_ARRAY_BUFFER binding of the streaming VBO
+	glBindBuffer(GL_COPY_WRITE_BUFFER, StaticVertexBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(NumStaticVertices) * StaticVertexSize, static_cast<GLsizeiptr>(NumVertices) * StaticVertexSize, Vertices);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	const INT First = NumStaticVertices;
+	NumStaticVertices += NumVertices;
+	return First;
+}
+
+void UXOpenGLRenderDevice::ShaderProgram::CreateDrawIDInputLayout()
+{
+	GLint PrevArrayBuffer = 0;
+	glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &PrevArrayBuffer);
+
+	// Without base instances, all draw calls of a glMultiDraw* call would see the same instanced DrawID
+	DrawBuffer.PerVertexDrawIDs = !RenDev->UsingIndirectDraws && !VertexlessDraws;
+
+	if (!DrawIDBuffer && DrawBuffer.PerVertexDrawIDs)
+	{
+		// MultiDrawBuffer fills this in before every batch
+		glGenBuffers(1, &DrawIDBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, DrawIDBuffer);
+		glBufferData(GL_ARRAY_BUFFER, VertexBufferSize * NUMBUFFERS * sizeof(glm::uint), nullptr, DRAWCALL_BUFFER_USAGE_PATTERN);
+	}
+	else if (!DrawIDBuffer)
+	{
+		// An identity buffer with a divisor of 1 hands every draw call the DrawID that
+		// matches its baseInstance. We need one DrawID per element of the parameters buffer
+		const INT NumDrawIDs = ParametersBufferSize * NUMBUFFERS;
+		TArray<glm::uint> DrawIDs;
+		DrawIDs.Add(NumDrawIDs);
+		for (INT i = 0; i < NumDrawIDs; ++i)
+			DrawIDs(i) = i;
+
+		glGenBuffers(1, &DrawIDBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, DrawIDBuffer);
+		glBufferData(GL_ARRAY_BUFFER, NumDrawIDs * sizeof(glm::uint), &DrawIDs(0), GL_STATIC_DRAW);
+	}
+	else
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, DrawIDBuffer);
+	}
+
+	glEnableVertexAttribArray(1);
+	glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(glm::uint), (GLvoid*)(0));
+	glVertexAttribDivisor(1, DrawBuffer.PerVertexDrawIDs ? 0 : 1);
+
+	glBindBuffer(GL_ARRAY_BUFFER, PrevArrayBuffer);
+}
+
+void UXOpenGLRenderDevice::ShaderProgram::DeleteDrawIDBuffer()
+{
+	if (DrawIDBuffer)
+	{
+		glDeleteBuffers(1, &DrawIDBuffer);
+		DrawIDBuffer = 0;
+	}
+}
+
+void UXOpenGLRenderDevice::ShaderProgram::CreateFanIndexBuffer(INT MaxVertices)
+{
+	if (!FanIndexBuffer)
+	{
+		// 16 bit indices are plenty since every fan has its own base vertex
+		MaxVertices = Min<INT>(MaxVertices, 65536);
+		TArray<GLushort> Indices;
+		Indices.Add((MaxVertices - 2) * 3);
+		for (INT i = 0; i < MaxVertices - 2; ++i)
+		{
+			Indices(i * 3    ) = 0;
+			Indices(i * 3 + 1) = static_cast<GLushort>(i + 1);
+			Indices(i * 3 + 2) = static_cast<GLushort>(i + 2);
+		}
+
+		glGenBuffers(1, &FanIndexBuffer);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, FanIndexBuffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, Indices.Num() * sizeof(GLushort), &Indices(0), GL_STATIC_DRAW);
+	}
+	else
+	{
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, FanIndexBuffer);
+	}
+}
+
+void UXOpenGLRenderDevice::ShaderProgram::DeleteFanIndexBuffer()
+{
+	if (FanIndexBuffer)
+	{
+		glDeleteBuffers(1, &FanIndexBuffer);
+		FanIndexBuffer = 0;
+	}
+}
+
+void UXOpenGLRenderDevice::ShaderProgram::DrawStaticGeometry()
+{
+	if (RenDev->ArrayPoint)
+		RenDev->ArrayPoint->Unbind();
+	glBindVertexArray(StaticVAO);
+	DrawBuffer.DrawIndirect(DrawMode);
+	glBindVertexArray(0);
+}
+
 /*-----------------------------------------------------------------------------
     ShaderCompilationOptions
 -----------------------------------------------------------------------------*/
@@ -840,6 +1080,10 @@ void UXOpenGLRenderDevice::ShaderCompilationOptions::SetOptionsForRendererConfig
 		SetOption(OPT_ClipDistance);
 	if (GIsEditor)
 		SetOption(OPT_Editor);
+	if (RenDev->UsingStaticBSPCache)
+		SetOption(OPT_StaticBSPCache);
+	if (RenDev->UsingTextureArrays)
+		SetOption(OPT_TextureArrays);
 }
 
 FString UXOpenGLRenderDevice::ShaderCompilationOptions::GetStringHelper(void (*AddOptionFunc)(FString&, const TCHAR*, bool)) const
@@ -864,6 +1108,8 @@ AddOptionFunc(Result, L ## #x, (OptionsMask & x) ? true : false);
     ADD_OPTION(OPT_ShaderDrawParameters)
     ADD_OPTION(OPT_ClipDistance)
     ADD_OPTION(OPT_Editor)
+    ADD_OPTION(OPT_StaticBSPCache)
+    ADD_OPTION(OPT_TextureArrays)
     
     if (Result.Len() == 0)
         AddOptionFunc(Result, TEXT("OPT_None"), true);
@@ -924,7 +1170,7 @@ UXOpenGLRenderDevice::NoProgram::NoProgram(const TCHAR* Name, UXOpenGLRenderDevi
 }
 
 void UXOpenGLRenderDevice::NoProgram::CreateInputLayout()			{}
-void UXOpenGLRenderDevice::NoProgram::Flush(bool Rotate)			{}
+void UXOpenGLRenderDevice::NoProgram::Flush(bool Rotate, FlushReason Reason)	{}
 void UXOpenGLRenderDevice::NoProgram::MapBuffers()					{}
 void UXOpenGLRenderDevice::NoProgram::UnmapBuffers()				{}
 void UXOpenGLRenderDevice::NoProgram::ActivateShader()				{}
@@ -30,6 +30,12 @@
 #include <sys/time.h>
 #endif
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #if !_WIN32
 namespace
 {
@@ -91,6 +97,149 @@ namespace
 }
 #endif
 
+/*-----------------------------------------------------------------------------
+	FGLWorkerPool.
+-----------------------------------------------------------------------------*/
+
+//
+// Fork/join helper for CPU-heavy loops such as converting big Gouraud poly lists.
+// Run splits [0, Count) into contiguous ranges. The calling thread works on them
+// too, and only returns once every range is done, so jobs may safely write to
+// disjoint parts of the mapped vertex buffers.
+//
+class FGLWorkerPool
+{
+public:
+	enum { MAX_WORKERS = 7 };
+
+	FGLWorkerPool(INT NumWorkers)
+	:	Exiting(false)
+	,	Generation(0)
+	,	Busy(0)
+	,	NextJob(0)
+	,	Remaining(0)
+	{
+		for (INT i = 0; i < Clamp(NumWorkers, 0, static_cast<INT>(MAX_WORKERS)); i++)
+			Workers.push_back(std::thread(&FGLWorkerPool::Work, this));
+	}
+
+	~FGLWorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			Exiting = true;
+		}
+		WorkAvailable.notify_all();
+		for (auto& Worker : Workers)
+			Worker.join();
+	}
+
+	INT NumThreads() const
+	{
+		return static_cast<INT>(Workers.size()) + 1;
+	}
+
+	void Run(INT Count, INT MinPerJob, UXOpenGLRenderDevice::FGLJobFunc Func, void* Context)
+	{
+		const INT NumJobs = Min(NumThreads(), Count / Max(MinPerJob, 1));
+		if (NumJobs < 2)
+		{
+			Func(Context, 0, Count);
+			return;
+		}
+
+		{
+			// Workers that are still checking out of the previous job must not pick up this one
+			std::unique_lock<std::mutex> Lock(Mutex);
+			Finished.wait(Lock, [&] { return Busy == 0; });
+
+			Job.Func = Func;
+			Job.Context = Context;
+			Job.Count = Count;
+			Job.NumJobs = NumJobs;
+			NextJob = 0;
+			Remaining = NumJobs;
+			Generation++;
+		}
+		WorkAvailable.notify_all();
+
+		RunJobs(Job);
+
+		std::unique_lock<std::mutex> Lock(Mutex);
+		Finished.wait(Lock, [&] { return Remaining == 0; });
+	}
+
+private:
+	struct FJob
+	{
+		UXOpenGLRenderDevice::FGLJobFunc Func;
+		void* Context;
+		INT Count;
+		INT NumJobs;
+	};
+
+	void RunJobs(const FJob& Current)
+	{
+		for (;;)
+		{
+			const INT Index = NextJob.fetch_add(1);
+			if (Index >= Current.NumJobs)
+				return;
+
+			// 64 bit math, since Count * NumJobs could overflow for huge lists
+			const INT Begin = static_cast<INT>(static_cast<SQWORD>(Current.Count) * Index / Current.NumJobs);
+			const INT End = static_cast<INT>(static_cast<SQWORD>(Current.Count) * (Index + 1) / Current.NumJobs);
+			Current.Func(Current.Context, Begin, End);
+
+			if (Remaining.fetch_sub(1) == 1)
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				Finished.notify_all();
+			}
+		}
+	}
+
+	void Work()
+	{
+		DWORD SeenGeneration = 0;
+		for (;;)
+		{
+			FJob Current;
+			{
+				std::unique_lock<std::mutex> Lock(Mutex);
+				WorkAvailable.wait(Lock, [&] { return Exiting || Generation != SeenGeneration; });
+				if (Exiting)
+					return;
+				SeenGeneration = Generation;
+				Current = Job;
+				Busy++;
+			}
+
+			RunJobs(Current);
+
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				Busy--;
+			}
+			Finished.notify_all();
+		}
+	}
+
+	std::vector<std::thread> Workers;
+	std::mutex Mutex;
+	std::condition_variable WorkAvailable;
+	std::condition_variable Finished;
+
+	// Guarded by Mutex
+	bool Exiting;
+	DWORD Generation;
+	INT Busy;
+	FJob Job;
+
+	std::atomic<INT> NextJob;
+	std::atomic<INT> Remaining;
+};
+
 /*-----------------------------------------------------------------------------
 	UXOpenGLDrv.
 -----------------------------------------------------------------------------*/
@@ -174,7 +323,6 @@ void UXOpenGLRenderDevice::StaticConstructor()
 	new(GetClass(), TEXT("UseHWLighting"), RF_Public)UBoolProperty(CPP_PROPERTY(UseHWLighting), TEXT("Options"), CPF_Config);
 	new(GetClass(), TEXT("UseHWClipping"), RF_Public)UBoolProperty(CPP_PROPERTY(UseHWClipping), TEXT("Options"), CPF_Config);
 	new(GetClass(), TEXT("UseEnhancedLightmaps"), RF_Public)UBoolProperty(CPP_PROPERTY(UseEnhancedLightmaps), TEXT("Options"), CPF_Config);
-	//new(GetClass(),TEXT("UseMeshBuffering"),		RF_Public)UBoolProperty	( CPP_PROPERTY(UseMeshBuffering			), TEXT("Options"), CPF_Config);
 #endif
 
 #if UNREAL_OLDUNREAL || UNREAL_TOURNAMENT_OLDUNREAL
@@ -182,6 +330,13 @@ void UXOpenGLRenderDevice::StaticConstructor()
 	new(GetClass(), TEXT("UsePersistentBuffers"), RF_Public)UBoolProperty(CPP_PROPERTY(UsePersistentBuffers), TEXT("Options"), CPF_Config);
 	new(GetClass(), TEXT("UseBindlessTextures"), RF_Public)UBoolProperty(CPP_PROPERTY(UseBindlessTextures), TEXT("Options"), CPF_Config);
 	new(GetClass(), TEXT("UseShaderDrawParameters"), RF_Public)UBoolProperty(CPP_PROPERTY(UseShaderDrawParameters), TEXT("Options"), CPF_Config);
+	new(GetClass(), TEXT("UseStaticBSPCache"), RF_Public)UBoolProperty(CPP_PROPERTY(UseStaticBSPCache), TEXT("Options"), CPF_Config);
+	new(GetClass(), TEXT("UseMeshBuffering"), RF_Public)UBoolProperty(CPP_PROPERTY(UseMeshBuffering), TEXT("Options"), CPF_Config);
+	new(GetClass(), TEXT("UseDeferredOpaqueDraws"), RF_Public)UBoolProperty(CPP_PROPERTY(UseDeferredOpaqueDraws), TEXT("Options"), CPF_Config);
+	new(GetClass(), TEXT("UseWorkerThreads"), RF_Public)UBoolProperty(CPP_PROPERTY(UseWorkerThreads), TEXT("Options"), CPF_Config);
+	new(GetClass(), TEXT("UseTileAtlas"), RF_Public)UBoolProperty(CPP_PROPERTY(UseTileAtlas), TEXT("Options"), CPF_Config);
+	new(GetClass(), TEXT("UseTextureArrays"), RF_Public)UBoolProperty(CPP_PROPERTY(UseTextureArrays), TEXT("Options"), CPF_Config);
+	new(GetClass(), TEXT("UseGPUTriangleRejection"), RF_Public)UBoolProperty(CPP_PROPERTY(UseGPUTriangleRejection), TEXT("Options"), CPF_Config);
 	
 	// Debug Options
 	new(GetClass(), TEXT("DebugLevel"), RF_Public)UIntProperty(CPP_PROPERTY(DebugLevel), TEXT("DebugOptions"), CPF_Config);
@@ -237,6 +392,12 @@ void UXOpenGLRenderDevice::StaticConstructor()
 	UseBindlessTextures = 1;
 #if UNREAL_OLDUNREAL || UNREAL_TOURNAMENT_OLDUNREAL
 	//UseShaderDrawParameters = 1; // setting this to true slightly improves performance on nvidia cards // stijn: disabled by default because many AMD drivers choke on it
+	UseStaticBSPCache = 0;
+	UseDeferredOpaqueDraws = 0;
+	UseWorkerThreads = 0;
+	UseTileAtlas = 0;
+	UseTextureArrays = 0;
+	UseGPUTriangleRejection = 0;
 #endif
 #if UNREAL_OLDUNREAL
 	UseHWLighting = 0;
@@ -399,6 +560,9 @@ UBOOL UXOpenGLRenderDevice::Init(UViewport* InViewport, INT NewX, INT NewY, INT
 
 	// Extensions & other inits.
 	ActiveProgram = No_Prog;
+	DeferredPrograms = 0;
+	ProgramFlushReason = Flush_Program;
+	WorkerPool = NULL;
 	SupportsAMDMemoryInfo = false;
 	SupportsNVIDIAMemoryInfo = false;
 	IsAMD = false;
@@ -424,6 +588,13 @@ UBOOL UXOpenGLRenderDevice::Init(UViewport* InViewport, INT NewX, INT NewY, INT
 #if UNREAL_OLDUNREAL || UNREAL_TOURNAMENT_OLDUNREAL
 	debugf(NAME_DevLoad, TEXT("UseBindlessTextures %i"), UseBindlessTextures);
 	debugf(NAME_DevLoad, TEXT("UseShaderDrawParameters %i"), UseShaderDrawParameters);
+	debugf(NAME_DevLoad, TEXT("UseStaticBSPCache %i"), UseStaticBSPCache);
+	debugf(NAME_DevLoad, TEXT("UseMeshBuffering %i"), UseMeshBuffering);
+	debugf(NAME_DevLoad, TEXT("UseDeferredOpaqueDraws %i"), UseDeferredOpaqueDraws);
+	debugf(NAME_DevLoad, TEXT("UseWorkerThreads %i"), UseWorkerThreads);
+	debugf(NAME_DevLoad, TEXT("UseTileAtlas %i"), UseTileAtlas);
+	debugf(NAME_DevLoad, TEXT("UseTextureArrays %i"), UseTextureArrays);
+	debugf(NAME_DevLoad, TEXT("UseGPUTriangleRejection %i"), UseGPUTriangleRejection);
 	debugf(NAME_DevLoad, TEXT("UseHWClipping %i"), UseHWClipping);
 #endif
 	debugf(NAME_DevLoad, TEXT("UseTrilinear %i"), UseTrilinear);
@@ -492,7 +663,6 @@ UBOOL UXOpenGLRenderDevice::Init(UViewport* InViewport, INT NewX, INT NewY, INT
 #else
 	UseHWClipping = 0;
 #endif
-	UseMeshBuffering = 0;
 
 	EnvironmentMaps = 0; //not yet implemented.
 
@@ -561,6 +731,9 @@ UBOOL UXOpenGLRenderDevice::Init(UViewport* InViewport, INT NewX, INT NewY, INT
 		return 0;
 	}
 
+	// Submit draw calls with glMultiDraw*Indirect. The baseInstance of each command selects its DrawID
+	UsingIndirectDraws = OpenGLVersion == GL_Core && glMultiDrawArraysIndirect && glMultiDrawElementsIndirect && glVertexAttribDivisor;
+
 #if UNREAL_OLDUNREAL || UNREAL_TOURNAMENT_OLDUNREAL
     // Doing after extensions have been checked.
 	UsingPersistentBuffers = UsePersistentBuffers ? true : false;
@@ -576,10 +749,45 @@ UBOOL UXOpenGLRenderDevice::Init(UViewport* InViewport, INT NewX, INT NewY, INT
 
 	// Bindless Textures
 	UsingBindlessTextures = UseBindlessTextures ? true : false;
+
+	// The static geometry caches always submit through indirect draw commands. The editor changes the BSP in place
+	const bool SupportsStaticGeometry = UsingIndirectDraws;
+	UsingStaticBSPCache = UseStaticBSPCache && SupportsStaticGeometry && !GIsEditor;
+	UsingMeshBuffering = UseMeshBuffering && SupportsStaticGeometry;
+	if ((UseStaticBSPCache || UseMeshBuffering) && !SupportsStaticGeometry)
+		GWarn->Logf(TEXT("XOpenGL: UseStaticBSPCache or UseMeshBuffering is enabled, but this device does not support indirect draws with base instances. Disabling these options"));
+
+	// Deferred batches must not depend on the texture units, which are shared by all programs
+	UsingDeferredOpaqueDraws = UseDeferredOpaqueDraws && UsingBindlessTextures;
+	if (UseDeferredOpaqueDraws && !UsingBindlessTextures)
+		GWarn->Logf(TEXT("XOpenGL: UseDeferredOpaqueDraws requires bindless textures. Disabling this option"));
+
+	UsingWorkerThreads = UseWorkerThreads ? true : false;
+
+	// Bindless textures never flush on texture changes, so the atlas would only cost us memory.
+	// The atlas pages are neither shared between contexts nor stored in sRGB either
+	UsingTileAtlas = UseTileAtlas && !UsingBindlessTextures && !GIsEditor && !UseSRGBTextures;
+
+	// Texture array pools have the same restrictions. They also keep the mip chain of the texture as-is
+	UsingTextureArrays = UseTextureArrays && !UsingBindlessTextures && !GIsEditor && !UseSRGBTextures && !GenerateMipMaps;
+
+	// Only the UT renderer interface hands us whole triangle lists. 227 toggles GL_CULL_FACE in SetBlend instead
+#if UNREAL_TOURNAMENT_OLDUNREAL
+	UsingGPUTriangleRejection = UseGPUTriangleRejection && !GIsEditor;
+#else
+	UsingGPUTriangleRejection = false;
+#endif
 #else
 	UsingBindlessTextures = false;
 	UsingPersistentBuffers = false;
 	UsingShaderDrawParameters = false;
+	UsingStaticBSPCache = false;
+	UsingMeshBuffering = false;
+	UsingDeferredOpaqueDraws = false;
+	UsingWorkerThreads = false;
+	UsingTileAtlas = false;
+	UsingTextureArrays = false;
+	UsingGPUTriangleRejection = false;
 #endif
 
 	if (OpenGLVersion == GL_Core
@@ -592,6 +800,9 @@ UBOOL UXOpenGLRenderDevice::Init(UViewport* InViewport, INT NewX, INT NewY, INT
 		UsingGeometryShaders = true;
 	}
 
+	// Draw polygons as indexed fans rather than unfanning them on the CPU
+	UsingIndexedFans = glDrawElementsBaseVertex != nullptr;
+
 	LogLevel = DebugLevel;
 
 	// For matrix setup in SetSceneNode()
@@ -626,7 +837,17 @@ UBOOL UXOpenGLRenderDevice::Init(UViewport* InViewport, INT NewX, INT NewY, INT
 	SetFrameStateUniforms();
 
 	if (UseAA)
-		glEnable(GL_MULTISAMPLE);
+		GLState.SetEnabled(GL_MULTISAMPLE, true);
+
+	if (UsingWorkerThreads)
+	{
+		// The game thread works on the jobs too
+		const INT NumCores = static_cast<INT>(std::thread::hardware_concurrency());
+		const INT NumWorkers = NumCores - 1;
+		if (NumWorkers > 0)
+			WorkerPool = new FGLWorkerPool(NumWorkers);
+		debugf(NAME_DevLoad, TEXT("XOpenGL: Using %i worker threads"), WorkerPool ? WorkerPool->NumThreads() - 1 : 0);
+	}
 
 	NumDevices++;
 	return 1;
@@ -747,6 +968,19 @@ void UXOpenGLRenderDevice::SelectGLVersion()
 				SelectedMinorVersion = Max<INT>(6, SelectedMinorVersion);
 			}
 		}
+		if (UseStaticBSPCache || UseMeshBuffering)
+		{
+			if (!IsSupportedGLVersion(4, 3))
+			{
+				debugf(TEXT("XOpenGL: UseStaticBSPCache or UseMeshBuffering is enabled, but this device does not support OpenGL 4.3. We will disable these options"));
+				UseStaticBSPCache = UseMeshBuffering = false;
+			}
+			else
+			{
+				SelectedMajorVersion = Max<INT>(4, SelectedMajorVersion);
+				SelectedMinorVersion = Max<INT>(3, SelectedMinorVersion);
+			}
+		}
         if (UseBindlessTextures || UsePersistentBuffers)
         {
 			if (!IsSupportedGLVersion(4, 5))
@@ -978,6 +1212,7 @@ void UXOpenGLRenderDevice::MakeCurrent()
 		if (!Result)
 			debugf(TEXT("XOpenGL: MakeCurrent failed with: %ls"), appFromAnsi(SDL_GetError()));
 		CurrentGLContext = glContext;
+		GLState.Invalidate();
 	}
 #else
 	if (!glContext && !CurrentGLContext)
@@ -993,20 +1228,35 @@ void UXOpenGLRenderDevice::MakeCurrent()
 		if (!wglMakeCurrent(hDC, glContext))
 			debugf(NAME_Warning, TEXT("wglMakeCurrent failed for (%p, %p). GetLastError: %d %s"), hDC, glContext, appGetSystemErrorCode(), appGetSystemErrorMessage());
 		CurrentGLContext = glContext;
+
+		// Another device might have changed the state of this context
+		GLState.Invalidate();
 	}
 #endif
 	unguard;
 }
 
+void UXOpenGLRenderDevice::ParallelFor(INT Count, INT MinPerJob, FGLJobFunc Func, void* Context)
+{
+	if (WorkerPool)
+		WorkerPool->Run(Count, MinPerJob, Func, Context);
+	else
+		Func(Context, 0, Count);
+}
+
 void UXOpenGLRenderDevice::SetPermanentState()
 {
+	// We just created or switched contexts. Forget everything we knew about the GL state
+	GLState.Invalidate();
+
 	// Set permanent state.
-	glEnable(GL_DEPTH_TEST);
-	glDepthMask(GL_TRUE);
+	GLState.SetEnabled(GL_DEPTH_TEST, true);
+	GLState.SetDepthMask(true);
 	glPolygonOffset(-1.0f, -1.0f);
-	glBlendFunc(GL_ONE, GL_ZERO);
-	glEnable(GL_BLEND);
-	glDisable(GL_CLIP_DISTANCE0);
+	GLState.SetBlendFunc(GL_ONE, GL_ZERO);
+	GLState.SetEnabled(GL_BLEND, true);
+	GLState.SetEnabled(GL_CLIP_DISTANCE0, false);
+	NumEnabledClipDistances = 0;
 
 	/*
 	GLES 3 supports sRGB functionality, but it does not expose the GL_FRAMEBUFFER_SRGB enable/disable bit.
@@ -1015,6 +1265,10 @@ void UXOpenGLRenderDevice::SetPermanentState()
 #ifndef __EMSCRIPTEN__
 	if (UseSRGBTextures && OpenGLVersion == GL_Core)
 		glEnable(GL_FRAMEBUFFER_SRGB);
+
+	// DrawSimplePointProgram sets the point size in the vertex shader. GLES always honors it
+	if (OpenGLVersion == GL_Core)
+		glEnable(GL_PROGRAM_POINT_SIZE);
 #endif
 
     if (UseAA && UseAASmoothing)
@@ -1044,10 +1298,11 @@ void UXOpenGLRenderDevice::SetPermanentState()
 	However, most gain is when using static meshes anyway, so this shouldn't be much of a problem for the other UEngine games.
 	*/
 	CurrentBlendPolyFlags = 0;
-	glEnable(GL_CULL_FACE);
-	glFrontFace(GL_CW);
-	glCullFace(GL_BACK);
+	GLState.SetEnabled(GL_CULL_FACE, true);
+	GLState.SetCullFace(GL_BACK);
 #endif
+	// UT only culls the triangle lists of UseGPUTriangleRejection, but they have the same winding
+	glFrontFace(GL_CW);
 }
 
 UBOOL UXOpenGLRenderDevice::SetRes(INT NewX, INT NewY, INT NewColorBytes, UBOOL Fullscreen)
@@ -1376,12 +1631,17 @@ void UXOpenGLRenderDevice::Flush(UBOOL AllowPrecache)
 		}
 	}
 	BindMap->Empty();
+	++BindMapSerial;
+	DeleteTileAtlas();
+	DeleteTexturePools();
 
 	if (Binds.Num())
 		glDeleteTextures(Binds.Num(), (GLuint*)&Binds(0));
+	GLState.InvalidateTextures();
 
 	for (INT i = 0; i < 8; i++) // Also reset all multi textures.
 		SetNoTexture(i);
+	ResetTextureLookups();
 
 	if (AllowPrecache && UsePrecache && !GIsEditor)
 		PrecacheOnFlip = 1;
@@ -1393,6 +1653,15 @@ void UXOpenGLRenderDevice::Flush(UBOOL AllowPrecache)
 
 	SetProgram(No_Prog);
 
+	// Rebuild the static geometry caches from scratch. The level geometry may have changed
+	for (INT i = 0; i < Max_Prog; ++i)
+		if (Shaders[i])
+			Shaders[i]->EmptyStaticCache();
+
+	// The model of the next map may reuse the address of the old one
+	if (auto ComplexShader = dynamic_cast<DrawComplexProgram*>(Shaders[Complex_Prog]))
+		ComplexShader->StaticModel = nullptr;
+
 	SwapControl();
 
 	if (DistanceFogBuffer.Buffer)
@@ -1453,6 +1722,17 @@ UBOOL UXOpenGLRenderDevice::Exec(const TCHAR* Cmd, FOutputDevice& Ar)
 		CurrentGLContext = NULL;
 		return 1;
 	}
+	else if (ParseCommand(&Cmd, TEXT("BENCHGOURAUDVERTS")))
+	{
+		BenchmarkGouraudVerts(Ar);
+		return 1;
+	}
+	else if (ParseCommand(&Cmd, TEXT("BENCHTEXTURELOOKUPS")))
+	{
+		// Unlock runs the benchmark once the next frame is done
+		RecordNextFrameCacheIDs = true;
+		return 1;
+	}
 	return 0;
 	unguard;
 }
@@ -1492,8 +1772,8 @@ void UXOpenGLRenderDevice::SetSceneNode(FSceneNode* Frame)
 	//avoid some overhead, only calculate and set again if something was really changed.
 	if (Frame->Viewport->IsOrtho() && (!bIsOrtho || StoredOrthoFovAngle != Viewport->Actor->FovAngle || StoredOrthoFX != Frame->FX || GIsEditor || StoredOrthoFY != Frame->FY))
 		SetOrthoProjection(Frame);
-	else if (StoredFovAngle != Viewport->Actor->FovAngle || StoredFX != Frame->FX || StoredFY != Frame->FY || GIsEditor || StoredbNearZ)
-		SetProjection(Frame, 0);
+	else if (StoredFovAngle != Viewport->Actor->FovAngle || StoredFX != Frame->FX || StoredFY != Frame->FY || GIsEditor)
+		SetProjection(Frame);
 #if UNREAL_OLDUNREAL
 	else if (BumpMaps) // stijn: TODO: We need this to prevent lights from jumping around. This indicates there's some problem in Render!
 		UpdateCoords(Frame);
@@ -1606,6 +1886,9 @@ void UXOpenGLRenderDevice::SetOrthoProjection(FSceneNode* Frame)
 {
 	guard(UXOpenGLRenderDevice::SetOrthoProjection);
 
+	// Deferred draw calls were buffered for the old projection
+	FlushDeferredPrograms(Flush_EndOfScene);
+
 	// Precompute stuff.
 	FLOAT zFar = (GIsEditor && Frame->Viewport->Actor->RendMap == REN_Wire) ? 131072.0 : 65336.f;
 
@@ -1628,33 +1911,28 @@ void UXOpenGLRenderDevice::SetOrthoProjection(FSceneNode* Frame)
 	bIsOrtho = true;
 
 	FrameState->modelviewprojMat = FrameState->projMat * FrameState->viewMat * FrameState->modelMat; //yes, this is right.
+	FrameState->modelviewprojMatNearZ = FrameState->modelviewprojMat;
 	FrameState->modelviewMat = FrameState->viewMat * FrameState->modelMat;
 
 	UpdateCoords(Frame);
 	unguard;
 }
 
-void UXOpenGLRenderDevice::SetProjection(FSceneNode* Frame, UBOOL bNearZ)
+void UXOpenGLRenderDevice::SetProjection(FSceneNode* Frame)
 {
 	guard(UXOpenGLRenderDevice::SetProjection);
 
-	// Precompute stuff.
-#if UNREAL_TOURNAMENT_OLDUNREAL
-	FLOAT zNear = 0.5f;
-#else
-    FLOAT zNear = 1.0f;
-#endif
-    StoredbNearZ = 0;
+	// Deferred draw calls were buffered for the old projection
+	FlushDeferredPrograms(Flush_EndOfScene);
 
-	if (bNearZ)
-    {
+	// Precompute stuff. We build both projections up front. Draw calls with DF_NearZ select the second one
 #if UNREAL_TOURNAMENT_OLDUNREAL
-		zNear = 0.5f;
+	FLOAT zNear = 0.5f;
+	FLOAT zNearZ = 0.5f;
 #else
-		zNear = 0.7f;
+	FLOAT zNear = 1.0f;
+	FLOAT zNearZ = 0.7f;
 #endif
-        StoredbNearZ = 1;
-    }
 
     FLOAT zFar = (GIsEditor && Frame->Viewport->Actor->RendMap == REN_Wire) ? 131072.0 : 65336.f;
 
@@ -1674,6 +1952,7 @@ void UXOpenGLRenderDevice::SetProjection(FSceneNode* Frame, UBOOL bNearZ)
 	glViewport(Frame->XB, Viewport->SizeY - Frame->Y - Frame->YB, Frame->X, Frame->Y);
 
 	FrameState->modelviewprojMat = FrameState->projMat * FrameState->viewMat * FrameState->modelMat;
+	FrameState->modelviewprojMatNearZ = glm::frustum(-RProjZ*zNearZ, +RProjZ*zNearZ, -Aspect*RProjZ*zNearZ, +Aspect*RProjZ*zNearZ, zNearZ, zFar) * FrameState->viewMat * FrameState->modelMat;
 	FrameState->modelviewMat = FrameState->viewMat * FrameState->modelMat;
 
 	UpdateCoords(Frame);
@@ -1686,18 +1965,48 @@ BYTE UXOpenGLRenderDevice::PushClipPlane(const FPlane& Plane)
 	if (NumClipPlanes == MaxClippingPlanes)
 		return 2;
 
-	Shaders[ActiveProgram]->Flush(false);
+	// 469 pushes the same near clip plane for every mesh. If the entry right above the active set
+	// already holds this plane, e.g. because we just popped it, we extend the set instead of appending a copy
+	const glm::vec4 NewPlane(Plane.X, Plane.Y, Plane.Z, Plane.W);
+	const GLuint Next = FirstClipPlane + NumClipPlanes;
+	if (Next < NumTableClipPlanes && GlobalClipPlaneBuffer.GetElementPtr(0)->ClipPlanes[Next] == NewPlane)
+	{
+		if (NumClipPlanes == NumEnabledClipDistances)
+			GLState.SetEnabled(GL_CLIP_DISTANCE0 + NumEnabledClipDistances++, true);
 
-	glEnable(GL_CLIP_DISTANCE0 + NumClipPlanes);
+		++NumClipPlanes;
+		ActiveClipPlanes = FirstClipPlane | (NumClipPlanes << 16);
+		return 1;
+	}
 
-	const auto ClipPlaneInfo = GlobalClipPlaneBuffer.GetElementPtr(0);
-	ClipPlaneInfo->ClipParams = glm::vec4(NumClipPlanes, 1.f, 0.f, 0.f);
-	ClipPlaneInfo->ClipPlane = glm::vec4(Plane.X, Plane.Y, Plane.Z, Plane.W);
+	// The active plane set must be contiguous in the table. If other planes were
+	// appended since this set was created, we start a fresh copy at the end
+	const bool AtTail = FirstClipPlane + NumClipPlanes == NumTableClipPlanes;
+	if ((AtTail ? 1 : NumClipPlanes + 1) > MAX_CLIP_PLANES - NumTableClipPlanes)
+	{
+		// Table is full. Pending draws still reference it, so we have to dispatch them before we start over
+		FlushPendingDraws(Flush_ClipPlane);
+		ResetClipPlanes();
+	}
+	else if (!AtTail)
+	{
+		const auto Table = GlobalClipPlaneBuffer.GetElementPtr(0);
+		for (GLuint i = 0; i < NumClipPlanes; ++i)
+			Table->ClipPlanes[NumTableClipPlanes + i] = Table->ClipPlanes[FirstClipPlane + i];
+		FirstClipPlane = NumTableClipPlanes;
+		NumTableClipPlanes += NumClipPlanes;
+	}
 
-	GlobalClipPlaneBuffer.Bind();
-	GlobalClipPlaneBuffer.BufferData(true);
+	GlobalClipPlaneBuffer.GetElementPtr(0)->ClipPlanes[NumTableClipPlanes++] = NewPlane;
+	ClipPlanesDirty = true;
+
+	// Draws that use fewer planes write a positive distance to the clip distances they don't use,
+	// so enabling another one does not affect the draws we have already queued
+	if (NumClipPlanes == NumEnabledClipDistances)
+		GLState.SetEnabled(GL_CLIP_DISTANCE0 + NumEnabledClipDistances++, true);
 
 	++NumClipPlanes;
+	ActiveClipPlanes = FirstClipPlane | (NumClipPlanes << 16);
 
 	return 1;
 	unguard;
@@ -1709,22 +2018,46 @@ BYTE UXOpenGLRenderDevice::PopClipPlane()
 	if (NumClipPlanes == 0)
 		return 2;
 
-	Shaders[ActiveProgram]->Flush(false);
-
+	// The bottom NumClipPlanes-1 planes of the active set are exactly the set we had
+	// before the matching PushClipPlane, so popping does not touch the table. The popped
+	// plane stays right above the set, so PushClipPlane can take it back
 	--NumClipPlanes;
-	glDisable(GL_CLIP_DISTANCE0 + NumClipPlanes);
+	ActiveClipPlanes = FirstClipPlane | (NumClipPlanes << 16);
 
-	const auto ClipPlaneInfo = GlobalClipPlaneBuffer.GetElementPtr(0);
-	ClipPlaneInfo->ClipParams = glm::vec4(NumClipPlanes, 0.f, 0.f, 0.f);
-	ClipPlaneInfo->ClipPlane = glm::vec4(0.f, 0.f, 0.f, 0.f);
+	return 1;
+	unguard;
+}
 
-	GlobalClipPlaneBuffer.Bind();
-	GlobalClipPlaneBuffer.BufferData(true);
+void UXOpenGLRenderDevice::ResetClipPlanes()
+{
+	guard(UXOpenGLRenderDevice::ResetClipPlanes);
+
+	// Move the active plane set to the start of the table
+	const auto Table = GlobalClipPlaneBuffer.GetElementPtr(0);
+	for (GLuint i = 0; i < NumClipPlanes; ++i)
+		Table->ClipPlanes[i] = Table->ClipPlanes[FirstClipPlane + i];
+	FirstClipPlane = 0;
+	NumTableClipPlanes = NumClipPlanes;
+	ActiveClipPlanes = NumClipPlanes << 16;
+	ClipPlanesDirty = true;
+
+	// No queued draw needs the clip distances beyond the active set anymore
+	while (NumEnabledClipDistances > NumClipPlanes)
+		GLState.SetEnabled(GL_CLIP_DISTANCE0 + --NumEnabledClipDistances, false);
 
-	return 1;
 	unguard;
 }
 
+void UXOpenGLRenderDevice::BufferClipPlanes()
+{
+	if (!ClipPlanesDirty)
+		return;
+
+	GlobalClipPlaneBuffer.Bind();
+	GlobalClipPlaneBuffer.BufferData(true);
+	ClipPlanesDirty = false;
+}
+
 void UXOpenGLRenderDevice::UpdateRenderFBO(INT Width, INT Height)
 {
 	guard(UXOpenGLRenderDevice::UpdateRenderFBO);
@@ -1736,13 +2069,13 @@ void UXOpenGLRenderDevice::UpdateRenderFBO(INT Width, INT Height)
 
 	// Always create the single-sample color texture used by the postprocess pass.
 	glGenTextures(1, &RenderColorTexture);
-	glBindTexture(GL_TEXTURE_2D, RenderColorTexture);
+	GLState.BindTexture(UploadIndex, RenderColorTexture);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, Width, Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState.BindTexture(UploadIndex, 0);
 
 	GLenum Status;
 
@@ -1829,6 +2162,9 @@ void UXOpenGLRenderDevice::DestroyRenderFBO()
 	RenderFBOWidth  = 0;
 	RenderFBOHeight = 0;
 	RenderFBOBound  = FALSE;
+
+	// The color texture might still have been bound to a TMU
+	GLState.InvalidateTextures();
 }
 
 static INT LockCount = 0;
@@ -1875,7 +2211,22 @@ void UXOpenGLRenderDevice::Lock(FPlane InFlashScale, FPlane InFlashFog, FPlane S
 #endif
 
 	LastZMode = ZTEST_LessEqual;
-	glDepthFunc(GL_LEQUAL);
+	GLState.SetDepthFunc(GL_LEQUAL);
+
+	// Start new clip plane and fog tables. Unlock has dispatched every draw that referenced the old ones
+	ResetClipPlanes();
+	EmptyDistanceFogTable();
+
+	// Texture lookups only live for one frame
+	ResetTextureLookups();
+	FrameCount++;
+
+	if (RecordNextFrameCacheIDs)
+	{
+		RecordedCacheIDs.EmptyNoRealloc();
+		RecordingCacheIDs = true;
+		RecordNextFrameCacheIDs = false;
+	}
 
 	// Remember stuff.
 	FlashScale = InFlashScale;
@@ -1887,6 +2238,7 @@ void UXOpenGLRenderDevice::Lock(FPlane InFlashScale, FPlane InFlashFog, FPlane S
 
 	// Reset stats.
 	appMemzero(&Stats, sizeof(Stats));
+	GLState.Issued = GLState.Filtered = 0;
 
 	if (GIsEditor)
 	{
@@ -1910,6 +2262,12 @@ void UXOpenGLRenderDevice::Unlock(UBOOL Blit)
 
 	SetProgram(No_Prog);
 
+	if (RecordingCacheIDs)
+	{
+		RecordingCacheIDs = false;
+		BenchmarkTextureLookups(*GLog);
+	}
+
 	if (RenderFBOBound)
 	{
 		if (UseAA && RenderResolvedFBO)
@@ -2064,18 +2422,31 @@ FLOAT UXOpenGLRenderDevice::GetViewportGamma(UViewport* Viewport) const
 	return Gamma;
 }
 
-void UXOpenGLRenderDevice::SetProgram(INT NextProgram)
+void UXOpenGLRenderDevice::SetProgram(INT NextProgram, FlushReason Reason)
 {
 	guard(UXOpenGLRenderDevice::SetProgram);
 
 	if (ActiveProgram != NextProgram)
 	{
-		// Flush the old program
-		Shaders[ActiveProgram]->DeactivateShader();
+		if (CanDeferProgram(ActiveProgram) && CanDeferProgram(NextProgram))
+		{
+			// Keep the old program's batch open. Opaque draws are depth-tested, so it does not
+			// matter whether we dispatch them before or after the draws of the next program
+			DeferredPrograms |= 1 << ActiveProgram;
+		}
+		else
+		{
+			// Flush the old program. Switching to No_Prog means the caller wants everything on screen
+			ProgramFlushReason = (NextProgram == No_Prog && Reason == Flush_Program) ? Flush_EndOfScene : Reason;
+			Shaders[ActiveProgram]->DeactivateShader();
+			FlushDeferredPrograms(ProgramFlushReason);
+			ProgramFlushReason = Flush_Program;
+		}
 
-		// Switch and initialize the new program
+		// Switch and initialize the new program. If it still had a batch open, we just append to it
 		PrevProgram = ActiveProgram;
 		ActiveProgram = NextProgram;
+		DeferredPrograms &= ~(1 << ActiveProgram);
 
 		Shaders[ActiveProgram]->ActivateShader();
 	}
@@ -2083,34 +2454,108 @@ void UXOpenGLRenderDevice::SetProgram(INT NextProgram)
 	unguard;
 }
 
+bool UXOpenGLRenderDevice::CanDeferProgram(INT Program) const
+{
+	// We only reorder opaque, depth-writing world geometry. Everything else keeps its submission order
+	return UsingDeferredOpaqueDraws &&
+		!GIsEditor &&
+		(Program == Complex_Prog || (Program == Gouraud_Prog && BatchCullFace == GL_NONE)) &&
+		LastZMode == ZTEST_LessEqual &&
+		!Shaders[Program]->DrawBuffer.HasDepthBatches() &&
+		!(CurrentBlendPolyFlags & (PF_Translucent | PF_Modulated | PF_Invisible | PF_AlphaBlend | PF_Highlighted)) &&
+		(CurrentBlendPolyFlags & PF_Occlude);
+}
+
+void UXOpenGLRenderDevice::FlushDeferredPrograms(FlushReason Reason)
+{
+	guard(UXOpenGLRenderDevice::FlushDeferredPrograms);
+
+	if (!DeferredPrograms)
+		return;
+
+	// Deferred programs were recorded with the current global state, so we can dispatch them in any order
+	for (INT i = 0; i < Max_Prog; ++i)
+	{
+		if (DeferredPrograms & (1 << i))
+		{
+			Shaders[i]->ActivateShader();
+			Shaders[i]->Flush(false, Reason);
+		}
+	}
+	DeferredPrograms = 0;
+
+	// Restore the bindings of the active program
+	Shaders[ActiveProgram]->ActivateShader();
+
+	unguard;
+}
+
+void UXOpenGLRenderDevice::FlushPendingDraws(FlushReason Reason)
+{
+	Shaders[ActiveProgram]->Flush(false, Reason);
+	FlushDeferredPrograms(Reason);
+}
+
 #if ENGINE_VERSION==227
 void UXOpenGLRenderDevice::SetDistanceFog(FFogSurf& Surf)
 {
-	// Stop batching
-	Shaders[ActiveProgram]->Flush(false);
-	
-	auto DistanceFogInfo = DistanceFogBuffer.GetElementPtr(0);
-	DistanceFogInfo->FogColor = glm::vec4(Surf.FogColor.X, Surf.FogColor.Y, Surf.FogColor.Z, Surf.FogColor.W);
-	DistanceFogInfo->FogStart = Surf.FogDistanceStart;
-	DistanceFogInfo->FogEnd = Surf.FogDistanceEnd;
-	DistanceFogInfo->FogDensity = Surf.FogDensity;
-	DistanceFogInfo->FogMode = Surf.FogMode;
-	DistanceFogBuffer.Bind();
-	DistanceFogBuffer.BufferData(true);
+	DistanceFogInfo Fog;
+	Fog.FogColor = glm::vec4(Surf.FogColor.X, Surf.FogColor.Y, Surf.FogColor.Z, Surf.FogColor.W);
+	Fog.FogStart = Surf.FogDistanceStart;
+	Fog.FogEnd = Surf.FogDistanceEnd;
+	Fog.FogDensity = Surf.FogDensity;
+	Fog.FogMode = Surf.FogMode;
+
+	// Actors in the same zone share the same fog settings, so we usually find them in the table
+	const auto Table = DistanceFogBuffer.GetElementPtr(0);
+	for (INT i = 1; i < NumDistanceFogs; ++i)
+	{
+		if (!appMemcmp(&Table->DistanceFogs[i], &Fog, sizeof(Fog)))
+		{
+			ActiveDistanceFog = i;
+			return;
+		}
+	}
+
+	if (NumDistanceFogs == MAX_DISTANCE_FOGS)
+	{
+		// Table is full. Pending draws still reference it, so we have to dispatch them before we start over
+		FlushPendingDraws(Flush_DistanceFog);
+		EmptyDistanceFogTable();
+	}
+
+	Table->DistanceFogs[NumDistanceFogs] = Fog;
+	ActiveDistanceFog = NumDistanceFogs++;
+	DistanceFogDirty = true;
 }
 #endif // ENGINE_VERSION
 
 void UXOpenGLRenderDevice::ResetDistanceFog()
+{
+	ActiveDistanceFog = 0;
+}
+
+void UXOpenGLRenderDevice::EmptyDistanceFogTable()
 {
 #if ENGINE_VERSION==227
-	auto DistanceFogInfo = DistanceFogBuffer.GetElementPtr(0);
-	if (DistanceFogInfo->FogMode != -1)
-	{
-		Shaders[ActiveProgram]->Flush(false);
-		DistanceFogInfo->FogMode = -1;
-		DistanceFogBuffer.Bind();
-		DistanceFogBuffer.BufferData(true);
-	}
+	const auto Table = DistanceFogBuffer.GetElementPtr(0);
+	appMemzero(&Table->DistanceFogs[0], sizeof(DistanceFogInfo));
+	Table->DistanceFogs[0].FogMode = -1;
+	NumDistanceFogs = 1;
+	ActiveDistanceFog = 0;
+	DistanceFogDirty = true;
+#endif
+}
+
+void UXOpenGLRenderDevice::BufferDistanceFog()
+{
+#if ENGINE_VERSION==227
+	if (!DistanceFogDirty)
+		return;
+
+	DistanceFogBuffer.Bind();
+	DistanceFogBuffer.BufferData(true);
+	DistanceFogDirty = false;
 #endif
 }
 
@@ -2118,7 +2563,7 @@ void UXOpenGLRenderDevice::ClearZ(FSceneNode* Frame)
 {
 	guard(UXOpenGLRenderDevice::ClearZ);
 
-	Shaders[ActiveProgram]->Flush(false);
+	FlushPendingDraws(Flush_ClearZ);
 	
 	// stijn: you have a serious problem in Engine/Render if you need this SetSceneNode call here!
 #if !MACOSX
@@ -2206,6 +2651,9 @@ void UXOpenGLRenderDevice::Exit()
 	guard(UXOpenGLRenderDevice::Exit);
 	debugf(TEXT("XOpenGL: Exit"));
 
+	delete WorkerPool;
+	WorkerPool = NULL;
+
 	if (!GIsRequestingExit)
 	{
 		if (!GIsEditor)
@@ -2277,6 +2725,13 @@ void UXOpenGLRenderDevice::Exit()
 #endif
 	GConfig->SetString(TEXT("XOpenGLDrv.XOpenGLRenderDevice"), TEXT("UseBindlessTextures"), *FString::Printf(TEXT("%ls"), *GetTrueFalse(UseBindlessTextures)));
 	GConfig->SetString(TEXT("XOpenGLDrv.XOpenGLRenderDevice"), TEXT("UseShaderDrawParameters"), *FString::Printf(TEXT("%ls"), *GetTrueFalse(UseShaderDrawParameters)));
+	GConfig->SetString(TEXT("XOpenGLDrv.XOpenGLRenderDevice"), TEXT("UseStaticBSPCache"), *FString::Printf(TEXT("%ls"), *GetTrueFalse(UseStaticBSPCache)));
+	GConfig->SetString(TEXT("XOpenGLDrv.XOpenGLRenderDevice"), TEXT("UseMeshBuffering"), *FString::Printf(TEXT("%ls"), *GetTrueFalse(UseMeshBuffering)));
+	GConfig->SetString(TEXT("XOpenGLDrv.XOpenGLRenderDevice"), TEXT("UseDeferredOpaqueDraws"), *FString::Printf(TEXT("%ls"), *GetTrueFalse(UseDeferredOpaqueDraws)));
+	GConfig->SetString(TEXT("XOpenGLDrv.XOpenGLRenderDevice"), TEXT("UseWorkerThreads"), *FString::Printf(TEXT("%ls"), *GetTrueFalse(UseWorkerThreads)));
+	GConfig->SetString(TEXT("XOpenGLDrv.XOpenGLRenderDevice"), TEXT("UseTileAtlas"), *FString::Printf(TEXT("%ls"), *GetTrueFalse(UseTileAtlas)));
+	GConfig->SetString(TEXT("XOpenGLDrv.XOpenGLRenderDevice"), TEXT("UseTextureArrays"), *FString::Printf(TEXT("%ls"), *GetTrueFalse(UseTextureArrays)));
+	GConfig->SetString(TEXT("XOpenGLDrv.XOpenGLRenderDevice"), TEXT("UseGPUTriangleRejection"), *FString::Printf(TEXT("%ls"), *GetTrueFalse(UseGPUTriangleRejection)));
 	GConfig->SetString(TEXT("XOpenGLDrv.XOpenGLRenderDevice"), TEXT("UsePersistentBuffers"), *FString::Printf(TEXT("%ls"), *GetTrueFalse(UsePersistentBuffers)));
 	GConfig->SetString(TEXT("XOpenGLDrv.XOpenGLRenderDevice"), TEXT("GenerateMipMaps"), *FString::Printf(TEXT("%ls"), *GetTrueFalse(GenerateMipMaps)));
 	GConfig->SetString(TEXT("XOpenGLDrv.XOpenGLRenderDevice"), TEXT("UseBufferInvalidation"), *FString::Printf(TEXT("%ls"), *GetTrueFalse(UseBufferInvalidation)));
@@ -2389,6 +2844,20 @@ void UXOpenGLRenderDevice::GetStats(TCHAR* Result)
     StatsString += *FString::Printf(TEXT("NumStaticLights %i\n"),NumLights);
 #endif
 
+	DWORD TotalFlushes = 0;
+	for (INT i = Flush_None + 1; i < Flush_Max; ++i)
+		TotalFlushes += Stats.Flushes[i];
+	StatsString += *FString::Printf(TEXT("GL state changes issued/filtered=%i/%i\n"), GLState.Issued, GLState.Filtered);
+	StatsString += *FString::Printf(TEXT("Flushes=%i\nLargest batch=%i draw calls\n"), TotalFlushes, Stats.MaxBatchDrawCalls);
+	for (INT i = Flush_None + 1; i < Flush_Max; ++i)
+	{
+		if (Stats.Flushes[i])
+			StatsString += *FString::Printf(TEXT("Flush %ls=%i (%04.1f draw calls/%04.1f vertices per flush)\n"),
+				FlushReasonNames[i], Stats.Flushes[i],
+				static_cast<FLOAT>(Stats.FlushedDrawCalls[i]) / Stats.Flushes[i],
+				static_cast<FLOAT>(Stats.FlushedVertices[i]) / Stats.Flushes[i]);
+	}
+
 #ifndef __LINUX_ARM__
 	if (SupportsNVIDIAMemoryInfo)
 	{
@@ -2472,6 +2941,26 @@ void UXOpenGLRenderDevice::DrawStats(FSceneNode* Frame)
     Canvas->CurX = 400;
 	Canvas->CurY = (CurY += 12);
 	Canvas->WrappedPrintf(Canvas->MedFont, 0, TEXT("Persistent buffer stalls = %i"), Stats.StallCount);
+	Canvas->CurX = 400;
+	Canvas->CurY = (CurY += 12);
+	Canvas->WrappedPrintf(Canvas->MedFont, 0, TEXT("GL state changes issued/filtered = %i/%i"), GLState.Issued, GLState.Filtered);
+
+	DWORD TotalFlushes = 0;
+	for (INT i = Flush_None + 1; i < Flush_Max; ++i)
+		TotalFlushes += Stats.Flushes[i];
+	Canvas->CurX = 400;
+	Canvas->CurY = (CurY += 24);
+	Canvas->WrappedPrintf(Canvas->MedFont, 0, TEXT("Flushes: %i (largest batch %i draw calls)"), TotalFlushes, Stats.MaxBatchDrawCalls);
+	for (INT i = Flush_None + 1; i < Flush_Max; ++i)
+	{
+		if (!Stats.Flushes[i])
+			continue;
+		Canvas->CurX = 400;
+		Canvas->CurY = (CurY += 12);
+		Canvas->WrappedPrintf(Canvas->MedFont, 0, TEXT("Flush %ls = %i (%04.1f draws/%05.1f verts)"), FlushReasonNames[i], Stats.Flushes[i],
+			static_cast<FLOAT>(Stats.FlushedDrawCalls[i]) / Stats.Flushes[i],
+			static_cast<FLOAT>(Stats.FlushedVertices[i]) / Stats.Flushes[i]);
+	}
 
 #ifndef __LINUX_ARM__
 	if (SupportsNVIDIAMemoryInfo)
@@ -2515,6 +3004,23 @@ PFNWGLCREATECONTEXTATTRIBSARBPROC UXOpenGLRenderDevice::wglCreateContextAttribsA
 PFNWGLGETEXTENSIONSSTRINGARBPROC UXOpenGLRenderDevice::wglGetExtensionsStringARB = nullptr;
 #endif
 INT	  UXOpenGLRenderDevice::LogLevel = 0;
+const TCHAR* UXOpenGLRenderDevice::FlushReasonNames[Flush_Max] =
+{
+	TEXT("None"),
+	TEXT("BufferFull"),
+	TEXT("Texture"),
+	TEXT("Blend"),
+	TEXT("Program"),
+	TEXT("EndOfScene"),
+	TEXT("ClipPlane"),
+	TEXT("ZTest"),
+	TEXT("DepthTest"),
+	TEXT("DistanceFog"),
+	TEXT("NearZ"),
+	TEXT("PopHit"),
+	TEXT("ClearZ"),
+	TEXT("Culling"),
+};
 DWORD UXOpenGLRenderDevice::ComposeSize = 0;
 BYTE* UXOpenGLRenderDevice::Compose = NULL;
 INT   UXOpenGLRenderDevice::NumDevices = 0;
@@ -2523,6 +3029,7 @@ INT   UXOpenGLRenderDevice::SelectedMajorVersion = 3;
 INT   UXOpenGLRenderDevice::SelectedMinorVersion = 3;
 
 TOpenGLMap<QWORD, UXOpenGLRenderDevice::FCachedTexture> *UXOpenGLRenderDevice::SharedBindMap;
+DWORD UXOpenGLRenderDevice::BindMapSerial = 1;
 
 void autoInitializeRegistrantsXOpenGLDrv(void)
 {